@@ -0,0 +1,283 @@
+#include "batch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define BATCH_X86
+    #include <immintrin.h>
+#endif
+
+#define ROW_COUNT  65536
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef void (*KernelFunction)(const Bitboard *boards, const Direction *directions, size_t count,
+                               Bitboard *results, unsigned int *scores, bool *changed);
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static void MoveBatchScalar(const Bitboard *boards, const Direction *directions, size_t count,
+                            Bitboard *results, unsigned int *scores, bool *changed);
+#if defined(BATCH_X86)
+static void MoveBatchSSE4(const Bitboard *boards, const Direction *directions, size_t count,
+                          Bitboard *results, unsigned int *scores, bool *changed);
+static void MoveBatchAVX2(const Bitboard *boards, const Direction *directions, size_t count,
+                          Bitboard *results, unsigned int *scores, bool *changed);
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static const char *kernelNames[BATCH_KERNEL_COUNT] = { "scalar", "sse4", "avx2" };
+
+static const KernelFunction kernels[BATCH_KERNEL_COUNT] = {
+    MoveBatchScalar,
+#if defined(BATCH_X86)
+    MoveBatchSSE4,
+    MoveBatchAVX2,
+#else
+    MoveBatchScalar,
+    MoveBatchScalar,
+#endif
+};
+
+static BatchKernel currentKernel = BATCH_KERNEL_COUNT;    // Not selected yet
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+bool IsBatchKernelSupported(BatchKernel kernel)
+{
+    switch (kernel)
+    {
+    case BATCH_KERNEL_SCALAR: return true;
+#if defined(BATCH_X86)
+    case BATCH_KERNEL_SSE4: return __builtin_cpu_supports("sse4.1");
+    case BATCH_KERNEL_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+    default: return false;
+    }
+}
+
+// Force the kernel, used to compare the kernels against each other
+bool SetBatchKernel(BatchKernel kernel)
+{
+    if (!IsBatchKernelSupported(kernel)) return false;
+
+    currentKernel = kernel;
+    return true;
+}
+
+/*
+ * The AVX2 kernel if the CPU supports it, the scalar one otherwise, unless one
+ * was forced. Without gathers the SSE4 kernel is no faster than the scalar one,
+ * it only runs when forced.
+ */
+BatchKernel GetBatchKernel(void)
+{
+    if (currentKernel == BATCH_KERNEL_COUNT)
+    {
+        bool avx2 = IsBatchKernelSupported(BATCH_KERNEL_AVX2);
+
+        currentKernel = avx2 ? BATCH_KERNEL_AVX2 : BATCH_KERNEL_SCALAR;
+    }
+    return currentKernel;
+}
+
+const char *GetBatchKernelName(BatchKernel kernel)
+{
+    return kernel < BATCH_KERNEL_COUNT ? kernelNames[kernel] : "unknown";
+}
+
+/*
+ * Move every board in its own direction. The results, the score deltas and
+ * the changed flags are written at the same index as the source board.
+ * The directions must be valid and InitMoveTables() must be called before.
+ */
+void MoveBatch(const Bitboard *boards, const Direction *directions, size_t count,
+               Bitboard *results, unsigned int *scores, bool *changed)
+{
+    kernels[GetBatchKernel()](boards, directions, count, results, scores, changed);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+static void MoveBatchScalar(const Bitboard *boards, const Direction *directions, size_t count,
+                            Bitboard *results, unsigned int *scores, bool *changed)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        results[i] = ExecuteMove(boards[i], directions[i], &scores[i]);
+        changed[i] = results[i] != boards[i];
+    }
+}
+
+#if defined(BATCH_X86)
+
+/*
+ * Both vector kernels move the columns the same way the scalar code does:
+ * transpose the boards with the vertical directions, slide the rows with the
+ * left or the right table and transpose back. The transpose is the same
+ * nibble shuffle as Transpose() applied to every 64-bit lane.
+ */
+
+__attribute__((target("sse4.1")))
+static inline __m128i Transpose128(__m128i x)
+{
+    __m128i a1 = _mm_and_si128(x, _mm_set1_epi64x(0xF0F00F0FF0F00F0FULL));
+    __m128i a2 = _mm_and_si128(x, _mm_set1_epi64x(0x0000F0F00000F0F0ULL));
+    __m128i a3 = _mm_and_si128(x, _mm_set1_epi64x(0x0F0F00000F0F0000ULL));
+    __m128i a  = _mm_or_si128(a1, _mm_or_si128(_mm_slli_epi64(a2, 12), _mm_srli_epi64(a3, 12)));
+    __m128i b1 = _mm_and_si128(a, _mm_set1_epi64x(0xFF00FF0000FF00FFULL));
+    __m128i b2 = _mm_and_si128(a, _mm_set1_epi64x(0x00FF00FF00000000ULL));
+    __m128i b3 = _mm_and_si128(a, _mm_set1_epi64x(0x00000000FF00FF00ULL));
+
+    return _mm_or_si128(b1, _mm_or_si128(_mm_srli_epi64(b2, 24), _mm_slli_epi64(b3, 24)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i Transpose256(__m256i x)
+{
+    __m256i a1 = _mm256_and_si256(x, _mm256_set1_epi64x(0xF0F00F0FF0F00F0FULL));
+    __m256i a2 = _mm256_and_si256(x, _mm256_set1_epi64x(0x0000F0F00000F0F0ULL));
+    __m256i a3 = _mm256_and_si256(x, _mm256_set1_epi64x(0x0F0F00000F0F0000ULL));
+    __m256i a  = _mm256_or_si256(a1, _mm256_or_si256(_mm256_slli_epi64(a2, 12),
+                                                     _mm256_srli_epi64(a3, 12)));
+    __m256i b1 = _mm256_and_si256(a, _mm256_set1_epi64x(0xFF00FF0000FF00FFULL));
+    __m256i b2 = _mm256_and_si256(a, _mm256_set1_epi64x(0x00FF00FF00000000ULL));
+    __m256i b3 = _mm256_and_si256(a, _mm256_set1_epi64x(0x00000000FF00FF00ULL));
+
+    return _mm256_or_si256(b1, _mm256_or_si256(_mm256_srli_epi64(b2, 24),
+                                               _mm256_slli_epi64(b3, 24)));
+}
+
+// The vector kernels select the lane with the all ones mask
+static inline long long LaneMask(bool set) { return set ? -1LL : 0LL; }
+
+// Offset of the right slides in the row move table
+static inline int TableOffset(Direction direction)
+{
+    return (direction == MOVE_RIGHT || direction == MOVE_DOWN) ? ROW_COUNT : 0;
+}
+
+// SSE4.1 has no gathers, the 8 rows of 2 boards are looked up one by one
+__attribute__((target("sse4.1")))
+static void MoveBatchSSE4(const Bitboard *boards, const Direction *directions, size_t count,
+                          Bitboard *results, unsigned int *scores, bool *changed)
+{
+    const uint16_t *moveTable  = GetRowMoveTable();
+    const uint32_t *scoreTable = GetRowScoreTable();
+    size_t i = 0;
+
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128i source   = _mm_loadu_si128((const __m128i *)&boards[i]);
+        __m128i vertical = _mm_set_epi64x(LaneMask(directions[i + 1] >= MOVE_UP),
+                                          LaneMask(directions[i] >= MOVE_UP));
+        __m128i rows     = _mm_blendv_epi8(source, Transpose128(source), vertical);
+
+        uint16_t in[8], out[8];
+        _mm_storeu_si128((__m128i *)in, rows);
+
+        for (int board = 0; board < 2; board++)
+        {
+            int offset = TableOffset(directions[i + board]);
+            unsigned int score = 0;
+
+            for (int row = 0; row < BITBOARD_SIZE; row++)
+            {
+                uint16_t value = in[board * BITBOARD_SIZE + row];
+
+                out[board * BITBOARD_SIZE + row] = moveTable[offset + value];
+                score += scoreTable[value];
+            }
+            scores[i + board] = score;
+        }
+
+        __m128i moved  = _mm_loadu_si128((const __m128i *)out);
+        __m128i result = _mm_blendv_epi8(moved, Transpose128(moved), vertical);
+        __m128i same   = _mm_cmpeq_epi64(result, source);
+
+        int equal      = _mm_movemask_pd(_mm_castsi128_pd(same));
+
+        _mm_storeu_si128((__m128i *)&results[i], result);
+        changed[i]     = !(equal & 1);
+        changed[i + 1] = !(equal & 2);
+    }
+
+    MoveBatchScalar(boards + i, directions + i, count - i, results + i, scores + i, changed + i);
+}
+
+/*
+ * The 4 boards of the 256-bit vector are exactly 16 rows, they are widened
+ * to two vectors of 8 32-bit indices and looked up with gathers. The move
+ * table holds 16-bit rows, a gather reads 32 bits so the upper half is masked
+ * off (the table is padded for the read past the last row).
+ */
+__attribute__((target("avx2")))
+static void MoveBatchAVX2(const Bitboard *boards, const Direction *directions, size_t count,
+                          Bitboard *results, unsigned int *scores, bool *changed)
+{
+    const int *moveTable  = (const int *)GetRowMoveTable();
+    const int *scoreTable = (const int *)GetRowScoreTable();
+    const __m256i rowMask = _mm256_set1_epi32(0xFFFF);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const Direction *d = &directions[i];
+
+        __m256i source   = _mm256_loadu_si256((const __m256i *)&boards[i]);
+        __m256i vertical = _mm256_set_epi64x(LaneMask(d[3] >= MOVE_UP), LaneMask(d[2] >= MOVE_UP),
+                                             LaneMask(d[1] >= MOVE_UP), LaneMask(d[0] >= MOVE_UP));
+        __m256i rows     = _mm256_blendv_epi8(source, Transpose256(source), vertical);
+
+        // Rows of the boards 0, 1 and of the boards 2, 3
+        __m256i low  = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(rows));
+        __m256i high = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(rows, 1));
+
+        __m256i lowOffset  = _mm256_set_epi32(TableOffset(d[1]), TableOffset(d[1]),
+                                              TableOffset(d[1]), TableOffset(d[1]),
+                                              TableOffset(d[0]), TableOffset(d[0]),
+                                              TableOffset(d[0]), TableOffset(d[0]));
+        __m256i highOffset = _mm256_set_epi32(TableOffset(d[3]), TableOffset(d[3]),
+                                              TableOffset(d[3]), TableOffset(d[3]),
+                                              TableOffset(d[2]), TableOffset(d[2]),
+                                              TableOffset(d[2]), TableOffset(d[2]));
+
+        __m256i lowMoved  = _mm256_and_si256(rowMask, _mm256_i32gather_epi32(moveTable,
+                                             _mm256_add_epi32(low, lowOffset), 2));
+        __m256i highMoved = _mm256_and_si256(rowMask, _mm256_i32gather_epi32(moveTable,
+                                             _mm256_add_epi32(high, highOffset), 2));
+
+        __m256i lowScore  = _mm256_i32gather_epi32(scoreTable, low, 4);
+        __m256i highScore = _mm256_i32gather_epi32(scoreTable, high, 4);
+
+        // Every 128-bit half holds the 4 row scores of one board
+        lowScore  = _mm256_hadd_epi32(lowScore, lowScore);
+        lowScore  = _mm256_hadd_epi32(lowScore, lowScore);
+        highScore = _mm256_hadd_epi32(highScore, highScore);
+        highScore = _mm256_hadd_epi32(highScore, highScore);
+
+        scores[i]     = (unsigned int)_mm256_extract_epi32(lowScore, 0);
+        scores[i + 1] = (unsigned int)_mm256_extract_epi32(lowScore, 4);
+        scores[i + 2] = (unsigned int)_mm256_extract_epi32(highScore, 0);
+        scores[i + 3] = (unsigned int)_mm256_extract_epi32(highScore, 4);
+
+        // Narrow back to 16-bit rows, the pack works per 128-bit half so fix the order up
+        __m256i moved  = _mm256_permute4x64_epi64(_mm256_packus_epi32(lowMoved, highMoved), 0xD8);
+        __m256i result = _mm256_blendv_epi8(moved, Transpose256(moved), vertical);
+        int same       = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(result, source)));
+
+        _mm256_storeu_si256((__m256i *)&results[i], result);
+        changed[i]     = !(same & 1);
+        changed[i + 1] = !(same & 2);
+        changed[i + 2] = !(same & 4);
+        changed[i + 3] = !(same & 8);
+    }
+
+    MoveBatchScalar(boards + i, directions + i, count - i, results + i, scores + i, changed + i);
+}
+
+#endif  // BATCH_X86
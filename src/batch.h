@@ -0,0 +1,34 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "bitboard.h"
+
+/*
+ * Batched move kernel that advances many independent boards at once. The
+ * AVX2 kernel moves 4 boards per step with gathered row lookups, the SSE4
+ * kernel moves 2 boards per step, the scalar kernel is the reference and the
+ * fallback. The AVX2 kernel is selected at runtime if the CPU supports it, the
+ * SSE4 kernel only runs when forced for comparisons since it has no gathers
+ * and doesn't beat the scalar one. All of them produce bit-identical results
+ * to ExecuteMove().
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef enum { BATCH_KERNEL_SCALAR, BATCH_KERNEL_SSE4, BATCH_KERNEL_AVX2, BATCH_KERNEL_COUNT } BatchKernel;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+bool IsBatchKernelSupported(BatchKernel kernel);
+bool SetBatchKernel(BatchKernel kernel);
+BatchKernel GetBatchKernel(void);
+const char *GetBatchKernelName(BatchKernel kernel);
+
+void MoveBatch(const Bitboard *boards, const Direction *directions, size_t count,
+               Bitboard *results, unsigned int *scores, bool *changed);
+
+#endif  // BATCH_H
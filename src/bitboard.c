@@ -0,0 +1,198 @@
+#include "bitboard.h"
+
+#define ROW_COUNT  65536     // Every possible 16-bit row
+#define ROW_MASK   0xFFFFULL
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+// Slides to the lower nibble followed by slides to the higher nibble, padded for 32-bit gathers
+static uint16_t rowMoveTable[2 * ROW_COUNT + 2];
+static uint16_t *const rowLeftTable  = rowMoveTable;
+static uint16_t *const rowRightTable = rowMoveTable + ROW_COUNT;
+static uint32_t rowScoreTable[ROW_COUNT];    // Score of the row merges (same for both sides)
+
+static bool tablesReady = false;
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static uint16_t SlideRow(uint16_t row, uint32_t *score);
+static uint16_t ReverseRow(uint16_t row);
+static inline Bitboard MoveRows(Bitboard board, const uint16_t *table, unsigned int *score);
+static inline bool RowsCanMove(Bitboard board);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+void InitMoveTables(void)
+{
+    if (tablesReady) return;
+
+    for (unsigned int row = 0; row < ROW_COUNT; row++)
+    {
+        uint32_t score = 0;
+        uint16_t left  = SlideRow((uint16_t)row, &score);
+
+        /*
+         * Sliding to the right is the mirrored slide to the left, the merge
+         * score doesn't depend on the side because the same pairs get merged.
+         */
+
+        rowLeftTable[row] = left;
+        rowRightTable[ReverseRow((uint16_t)row)] = ReverseRow(left);
+        rowScoreTable[row] = score;
+    }
+
+    tablesReady = true;
+}
+
+Bitboard ExecuteMove(Bitboard board, Direction direction, unsigned int *score)
+{
+    switch (direction)
+    {
+    case MOVE_LEFT:  return MoveRows(board, rowLeftTable, score);
+    case MOVE_RIGHT: return MoveRows(board, rowRightTable, score);
+    case MOVE_UP:    return Transpose(MoveRows(Transpose(board), rowLeftTable, score));
+    case MOVE_DOWN:  return Transpose(MoveRows(Transpose(board), rowRightTable, score));
+    default:
+        *score = 0;
+        return board;
+    }
+}
+
+const uint16_t *GetRowMoveTable(void) { return rowMoveTable; }
+const uint32_t *GetRowScoreTable(void) { return rowScoreTable; }
+
+bool CanMove(Bitboard board)
+{
+    return RowsCanMove(board) || RowsCanMove(Transpose(board));
+}
+
+/*
+ * Put a new tile into a random empty cell: every empty cell is equally likely,
+ * the tile is a 2 with 90% probability and a 4 with 10% probability. Returns
+ * the cell index or -1 if the grid is full.
+ */
+int SpawnTile(Bitboard *board, RandomGenerator *random)
+{
+    int empty = CountEmptyCells(*board);
+
+    if (!empty) return -1;
+
+    int nth = (int)NextRandomBelow(random, empty);
+
+    for (int i = 0; i < BITBOARD_CELLS; i++)
+    {
+        if (!GetCell(*board, i) && nth-- == 0)
+        {
+            *board = SetCell(*board, i, NextRandomBelow(random, 10) ? 1 : 2);
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Swap rows and columns of the grid with the nibble shuffles
+Bitboard Transpose(Bitboard board)
+{
+    Bitboard a1 = board & 0xF0F00F0FF0F00F0FULL;
+    Bitboard a2 = board & 0x0000F0F00000F0F0ULL;
+    Bitboard a3 = board & 0x0F0F00000F0F0000ULL;
+    Bitboard a  = a1 | (a2 << 12) | (a3 >> 12);
+    Bitboard b1 = a & 0xFF00FF0000FF00FFULL;
+    Bitboard b2 = a & 0x00FF00FF00000000ULL;
+    Bitboard b3 = a & 0x00000000FF00FF00ULL;
+
+    return b1 | (b2 >> 24) | (b3 << 24);
+}
+
+int CountEmptyCells(Bitboard board)
+{
+    if (board == 0) return BITBOARD_CELLS;
+
+    // Collapse every nibble to its lowest bit and sum the bits up
+    board |= (board >> 2) & 0x3333333333333333ULL;
+    board |= (board >> 1);
+    board  = ~board & 0x1111111111111111ULL;
+
+    return (int)((board * 0x1111111111111111ULL) >> 60);
+}
+
+unsigned int GetMaxExponent(Bitboard board)
+{
+    unsigned int max = 0;
+
+    for (int i = 0; i < BITBOARD_CELLS; i++)
+    {
+        unsigned int value = GetCell(board, i);
+        if (value > max) max = value;
+    }
+    return max;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Slide a single row to the lower nibble merging the equal neighbours once
+static uint16_t SlideRow(uint16_t row, uint32_t *score)
+{
+    unsigned int cells[BITBOARD_SIZE] = { 0 };
+    int count = 0;
+    bool merged = false;
+
+    for (int i = 0; i < BITBOARD_SIZE; i++)
+    {
+        unsigned int value = (row >> (4 * i)) & 0xF;
+
+        if (!value) continue;
+
+        if (count > 0 && !merged && cells[count - 1] == value && value < BITBOARD_MAX_VALUE)
+        {
+            cells[count - 1]++;
+            *score += 2u << (value);    // Same as the value of the new tile
+            merged = true;
+        }
+        else
+        {
+            cells[count++] = value;
+            merged = false;
+        }
+    }
+
+    return (uint16_t)(cells[0] | (cells[1] << 4) | (cells[2] << 8) | (cells[3] << 12));
+}
+
+static uint16_t ReverseRow(uint16_t row)
+{
+    return (uint16_t)((row >> 12) | ((row >> 4) & 0x00F0) | ((row << 4) & 0x0F00) | (row << 12));
+}
+
+static inline Bitboard MoveRows(Bitboard board, const uint16_t *table, unsigned int *score)
+{
+    Bitboard result = 0;
+    unsigned int total = 0;
+
+    for (int i = 0; i < BITBOARD_SIZE; i++)
+    {
+        uint16_t row = (uint16_t)((board >> (16 * i)) & ROW_MASK);
+
+        result |= (Bitboard)table[row] << (16 * i);
+        total  += rowScoreTable[row];
+    }
+
+    *score = total;
+    return result;
+}
+
+static inline bool RowsCanMove(Bitboard board)
+{
+    for (int i = 0; i < BITBOARD_SIZE; i++)
+    {
+        uint16_t row = (uint16_t)((board >> (16 * i)) & ROW_MASK);
+
+        if (rowLeftTable[row] != row || rowRightTable[row] != row) return true;
+    }
+    return false;
+}
@@ -0,0 +1,51 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "random.h"
+
+/*
+ * Pure game logic core. The 4x4 grid is packed into a single 64-bit word
+ * where every cell holds a 4-bit exponent (0 - empty, 1 - tile 2, 2 - tile 4,
+ * ...). Cell (x, y) lives in the nibble number y*4 + x, so every row of the
+ * grid is a 16-bit chunk of the word and the moves are executed by the row
+ * lookup tables. This module must not depend on raylib.
+ */
+
+#define BITBOARD_SIZE        4
+#define BITBOARD_CELLS       (BITBOARD_SIZE * BITBOARD_SIZE)
+#define BITBOARD_MAX_VALUE   15    // Highest exponent a nibble can hold (32768)
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef uint64_t Bitboard;
+
+typedef enum { MOVE_LEFT, MOVE_RIGHT, MOVE_UP, MOVE_DOWN, MOVE_COUNT } Direction;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+void InitMoveTables(void);
+const uint16_t *GetRowMoveTable(void);     // Left slides of every row followed by right slides
+const uint32_t *GetRowScoreTable(void);
+
+Bitboard ExecuteMove(Bitboard board, Direction direction, unsigned int *score);
+bool CanMove(Bitboard board);
+int SpawnTile(Bitboard *board, RandomGenerator *random);
+Bitboard Transpose(Bitboard board);
+int CountEmptyCells(Bitboard board);
+unsigned int GetMaxExponent(Bitboard board);
+
+static inline unsigned int GetCell(Bitboard board, int cell)
+{
+    return (unsigned int)(board >> (4 * cell)) & 0xF;
+}
+
+static inline Bitboard SetCell(Bitboard board, int cell, unsigned int value)
+{
+    return (board & ~((Bitboard)0xF << (4 * cell))) | ((Bitboard)(value & 0xF) << (4 * cell));
+}
+
+#endif  // BITBOARD_H
@@ -1,16 +1,18 @@
-#include <stdlib.h>  // rand
-#include <stdio.h>   // sprintf
+#include <math.h>    // ceilf
 #include "board.h"
 #include "game.h"
-#include "observer.h"
-#include "resources.h"
+#include "profiler.h"
 #include "shapes.h"
+#include "textcache.h"
 #include "utils.h"
 
 #define MAX_COLOR_INDEX          12
-#define BUFFER_SIZE              10
-#define ANIMATION_MOVE_FRAMES    5
-#define ANIMATION_APPEAR_FRAMES  5
+#define ANIMATION_MOVE_TIME      0.1f    // Seconds
+#define ANIMATION_APPEAR_TIME    0.1f
+
+#define ATLAS_TILES              (BITBOARD_MAX_VALUE + 1)    // Empty cell and every tile value
+#define ATLAS_COLUMNS            6
+#define ATLAS_PADDING            2     // Keeps the bilinear filter from sampling the neighbours
 
 #define COLOR_WHITE   (Color){ 249, 246, 242, 255 }
 #define COLOR_GREY    (Color){ 119, 110, 102, 255 }
@@ -20,12 +22,6 @@
 //-------------------------------------------------------------------------------------------------
 // Local Variables Definition
 //-------------------------------------------------------------------------------------------------
-static Rectangle boardRec;
-static float spacing;
-static float tileSize;
-static float moveSpeed;
-static float appearSpeed;
-
 static Color tileColors[] = {
     (Color){ 238, 228, 218, 255 },    // 2
     (Color){ 237, 224, 200, 255 },    // 4
@@ -47,90 +43,109 @@ static Color tileColors[] = {
 //-------------------------------------------------------------------------------------------------
 static void ProcessPhisics(Board *board);
 static void AddTile(Board *board);
-static bool GridIsFull(Board *board);
-static Rectangle GetTileRec(const CellVector *v);
-static void Move(Board *board, int vx, int vy);
+static Rectangle GetTileRec(const BoardLayout *layout, const CellVector *v);
 static inline Color NumToColor(int value);
-static inline float lerp(float v0, float v1, int elapsed);
+static inline float lerp(const BoardLayout *layout, float v0, float v1, float progress);
+static void BakeTileAtlas(BoardLayout *layout);
+static void DrawAtlasTile(const BoardLayout *layout, int index, Rectangle rec);
 
 //-------------------------------------------------------------------------------------------------
 // Functions Definition
 //-------------------------------------------------------------------------------------------------
-void ResetBoard(Board *board)
+void ResetBoard(Board *board, int size, uint64_t seed)
 {
-    TraceLog(LOG_DEBUG, "Create New Board");
+    TraceLog(LOG_DEBUG, "Create New Board %dx%d (seed %llu)", size, size,
+             (unsigned long long)seed);
+
+    InitGrid(&board->grid, size);
 
     // Define board properties
-    board->moveFrames   = 0;
-    board->appearFrames = 0;
+    board->moveTime     = 0;
+    board->appearTime   = 0;
     board->state        = BOARD_STATE_NONE;
     board->animation    = ANIMATION_APPEAR;
+    board->seed         = seed;
+    board->lastMove     = MOVE_COUNT;
+    board->lastScore    = 0;
+    board->lastSpawn    = -1;
 
-    // Initialize the grid
-    for (int row = 0; row < SIZE; row++)
+    SeedRandomGenerator(&board->random, seed);
+
+    // Initialize the tiles, the tile index matches the grid cell index
+    for (int i = 0; i < size*size; i++)
     {
-        for (int col = 0; col < SIZE; col++)
-        {
-            Tile *tile        = &board->grid[row * SIZE + col];
-            tile->value       = 0;
-            tile->oldValue    = 0;
-            tile->position.x  = row;
-            tile->position.y  = col;
-            tile->source      = NULL;
-            tile->oldPosition = tile->position;
-        }
+        Tile *tile        = &board->tiles[i];
+        tile->value       = 0;
+        tile->oldValue    = 0;
+        tile->position.x  = i % size;
+        tile->position.y  = i / size;
+        tile->source      = NULL;
+        tile->oldPosition = tile->position;
     }
 
     AddTile(board);
     AddTile(board);
+
+    for (int i = 0; i < size*size; i++) board->tiles[i].oldValue = board->tiles[i].value;
 }
 
-void InitBoard(Rectangle *rec)
+// Rebuild the tiles of a loaded 4x4 board without any animation
+void RestoreBoard(Board *board, Bitboard cells)
+{
+    BitboardToGrid(cells, &board->grid);
+
+    board->moveTime     = 0;
+    board->appearTime   = 0;
+    board->state        = BOARD_STATE_NONE;
+    board->animation    = ANIMATION_NONE;
+    board->lastMove     = MOVE_COUNT;
+    board->lastScore    = 0;
+    board->lastSpawn    = -1;
+
+    for (int i = 0; i < BITBOARD_CELLS; i++)
+    {
+        Tile *tile        = &board->tiles[i];
+        tile->value       = GetCell(cells, i);
+        tile->oldValue    = tile->value;
+        tile->position.x  = i % BITBOARD_SIZE;
+        tile->position.y  = i / BITBOARD_SIZE;
+        tile->source      = NULL;
+        tile->oldPosition = tile->position;
+    }
+}
+
+// The layout starts unbaked, zero it before the first call
+void InitBoard(BoardLayout *layout, Rectangle *rec, int size)
 {
     TraceLog(LOG_DEBUG, "Init Board");
 
     // Define board rectangle
-    boardRec = *rec;
+    layout->rec  = *rec;
+    layout->size = size;
 
-    // Define board tile and spacing sizes
-    spacing  = boardRec.width * 0.03;
-    tileSize = (boardRec.width - 5*spacing) / SIZE;
+    // Define board tile and spacing sizes, the spacing takes 15% of the width on every size
+    layout->spacing  = layout->rec.width * 0.15f / (size + 1);
+    layout->tileSize = (layout->rec.width - (size + 1)*layout->spacing) / size;
 
-    // Define board animations
-    moveSpeed   = (tileSize + spacing) / ANIMATION_MOVE_FRAMES;
-    appearSpeed = (spacing * 0.5) / ANIMATION_APPEAR_FRAMES;
+    ClearTextLayouts();    // The tile font sizes changed
+
+    // Bake the tiles again only if their size changed
+    if (layout->atlasCell != (int)ceilf(layout->tileSize) + 2*ATLAS_PADDING) BakeTileAtlas(layout);
 }
 
-void HandleBoardInput(Board *board)
+void UnloadBoard(BoardLayout *layout)
 {
-    if (board->state == BOARD_STATE_NONE)
-    {
-        if (IsKeyPressed(KEY_RIGHT))        Move(board,  1,  0);
-        else if (IsKeyPressed(KEY_LEFT))    Move(board, -1,  0);
-        else if (IsKeyPressed(KEY_UP))      Move(board,  0, -1);
-        else if (IsKeyPressed(KEY_DOWN))    Move(board,  0,  1);
-    }
+    if (layout->atlasCell) UnloadRenderTexture(layout->atlas);
+    layout->atlasCell = 0;
 }
 
+// Advance the board logic and the animations by one fixed step of GAME_STEP_TIME
 void UpdateBoard(Board *board)
 {
     if (board->animation == ANIMATION_NONE)
     {
-        if (board->state == BOARD_STATE_MOVED)
-        {
-            board->animation = ANIMATION_MOVE;
-            PlaySound(moveSound);
-        }
-        else if (board->state == BOARD_STATE_MERGED)
-        {
-            if (GetGame()->score > GetGame()->best)
-            {
-                GetGame()->best = GetGame()->score;
-            }
-
-            board->animation = ANIMATION_MOVE;
-            PlaySound(mergeSound);
-        }
+        // The sound of the move is played on its event, see the gameplay screen
+        if (board->state != BOARD_STATE_NONE) board->animation = ANIMATION_MOVE;
     }
     else
     {
@@ -138,88 +153,114 @@ void UpdateBoard(Board *board)
     }
 }
 
-void DrawBoard(Board *board)
+/*
+ * The lag is the time elapsed since the last step, the animations are drawn
+ * that far ahead so they move smoothly at any frame rate.
+ */
+void DrawBoard(const BoardLayout *layout, const Board *board, float lag)
 {
-    char buffer[BUFFER_SIZE];
+    PROFILE_BEGIN(PROFILE_DRAW_BOARD);
+
+    float moved = 0;
+    float grown = 0;
+
+    if (board->animation == ANIMATION_MOVE)
+    {
+        moved = MIN(board->moveTime + lag, ANIMATION_MOVE_TIME) / ANIMATION_MOVE_TIME;
+    }
+    else if (board->animation == ANIMATION_APPEAR)
+    {
+        grown = MIN(board->appearTime + lag, ANIMATION_APPEAR_TIME) / ANIMATION_APPEAR_TIME;
+    }
 
     // Draw board background
-    DrawRoundedRectangleRec(boardRec, boardRec.width * 0.015, COLOR_BOARD);
+    DrawRoundedRectangleRec(layout->rec, layout->rec.width * 0.015, COLOR_BOARD);
+
+    int cells = board->grid.size * board->grid.size;
 
     // Draw grid cells
-    for (int i = 0; i < GRID_SIZE; i++)
+    for (int i = 0; i < cells; i++)
     {
-        Tile *tile    = &board->grid[i];
-        Rectangle rec = GetTileRec(&tile->oldPosition);
-        DrawRoundedRectangleRec(rec, tileSize * 0.05, COLOR_CELL);
+        const Tile *tile = &board->tiles[i];
+        Rectangle rec    = GetTileRec(layout, &tile->oldPosition);
+        DrawAtlasTile(layout, 0, rec);
     }
 
     // Draw grid tiles
-    for (int i = 0; i < GRID_SIZE; i++)
+    for (int i = 0; i < cells; i++)
     {
-        Tile *tile = &board->grid[i];
+        const Tile *tile = &board->tiles[i];
 
         if (tile->oldValue > 0)
         {
-            int font = (tile->oldValue < 10) ? tileSize * 0.5: tileSize * 0.4;
+            Rectangle rec = GetTileRec(layout, &tile->oldPosition);
 
-            Rectangle rec = GetTileRec(&tile->oldPosition);
-
-            rec.x += lerp(tile->position.x, tile->oldPosition.x, board->moveFrames);
-            rec.y += lerp(tile->position.y, tile->oldPosition.y, board->moveFrames);
+            rec.x += lerp(layout, tile->position.x, tile->oldPosition.x, moved);
+            rec.y += lerp(layout, tile->position.y, tile->oldPosition.y, moved);
 
             // Draw appear animation if tile was merged
-            if (board->appearFrames && tile->source)
+            if (grown > 0 && tile->source)
             {
-                float elapsed = board->appearFrames * appearSpeed;
+                float elapsed = grown * layout->spacing * 0.5f;
 
                 rec.x      -= elapsed;
                 rec.y      -= elapsed;
                 rec.height += elapsed * 2;
                 rec.width  += elapsed * 2;
-                font       += elapsed;
             }
 
-            // Convert an integer value to a string
-            sprintf(buffer, "%d", 2 << (tile->oldValue - 1));
-
-            // Center a tile value text position
-            Vector2 vector = (Vector2) {
-                rec.x + (rec.height * 0.5) - MeasureText(buffer, font) * 0.5,
-                rec.y + (rec.width * 0.5) - (font * 0.5)
-            };
-
-            // Define a tile value text color
-            Color color = (tile->oldValue <= 2) ? COLOR_GREY : COLOR_WHITE;
-
-            // Draw tile
-            DrawRoundedRectangleRec(rec, tileSize * 0.05, NumToColor(tile->oldValue));
-            DrawText(buffer, vector.x, vector.y, font, color);
+            // Draw tile, the pre-rendered one is scaled for the appear animation
+            DrawAtlasTile(layout, MIN(tile->oldValue, ATLAS_TILES - 1), rec);
         }
     }
+
+    PROFILE_END(PROFILE_DRAW_BOARD);
 }
 
-bool MoveIsAvailable(Board *board)
+bool MoveIsAvailable(const Board *board)
 {
-    if (!GridIsFull(board))
+    return CanMoveGrid(&board->grid);
+}
+
+/*
+ * Execute the move and spawn the new tile on the grid at once and derive
+ * the tiles animation from the result: every tile slides from its cell to
+ * the traced target cell, the merged cells and the new tile get the appear
+ * animation. An animation still running is dropped, the tiles start over
+ * from the board before the move. Returns false if no tile moved, the score
+ * of the move is left in lastScore.
+ */
+bool ApplyBoardMove(Board *board, Direction direction)
+{
+    GridTrace trace;
+    unsigned int score;
+    Grid moved = board->grid;
+
+    if (direction >= MOVE_COUNT || !MoveGrid(&moved, direction, &score)) return false;
+
+    TraceGridMove(&board->grid, direction, &trace);
+
+    board->moveTime   = 0;
+    board->appearTime = 0;
+    board->animation  = ANIMATION_NONE;
+
+    for (int i = 0; i < moved.size*moved.size; i++)
     {
-        return true;
+        Tile *tile     = &board->tiles[i];
+        tile->oldValue = GetGridCell(&board->grid, i);
+        tile->value    = GetGridCell(&moved, i);
+        tile->position = board->tiles[trace.target[i]].oldPosition;
+        tile->source   = trace.merged[i] ? tile : NULL;
     }
 
-    Tile *grid = board->grid;
-    for (int row = 0; row < SIZE; row++)
-    {
-        for (int col = 0; col < SIZE; col++)
-        {
-            int value = board->grid[row * SIZE + col].value;
+    board->grid      = moved;
+    board->lastMove  = direction;
+    board->lastScore = score;
+    board->state     = (score > 0) ? BOARD_STATE_MERGED : BOARD_STATE_MOVED;
 
-            if (row < SIZE - 1 && grid[(row + 1) * SIZE + col].value == value) return true;
-            if (col < SIZE - 1 && grid[row * SIZE + (col + 1)].value == value) return true;
-            if (row > 0 && grid[(row - 1) * SIZE + col].value == value) return true;
-            if (col > 0 && grid[row * SIZE + (col - 1)].value == value) return true;
-        }
-    }
+    AddTile(board);
 
-    return false;
+    return true;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -230,9 +271,79 @@ static inline Color NumToColor(int value)
     return value <= MAX_COLOR_INDEX + 1 ? tileColors[--value]: BLACK;
 }
 
-static inline float lerp(float v0, float v1, int elapsed)
+static inline float lerp(const BoardLayout *layout, float v0, float v1, float progress)
 {
-   return (v0 - v1) * elapsed * moveSpeed;
+   return (v0 - v1) * progress * (layout->tileSize + layout->spacing);
+}
+
+/*
+ * Draw the empty cell and every tile with its value into a render texture
+ * once, so a tile is a single textured quad instead of the rounded rectangle
+ * geometry and the text. Baked again whenever the tile size changes.
+ */
+static void BakeTileAtlas(BoardLayout *layout)
+{
+    float tileSize = layout->tileSize;
+
+    UnloadBoard(layout);
+
+    int atlasCell = (int)ceilf(tileSize) + 2*ATLAS_PADDING;
+
+    layout->atlasCell = atlasCell;
+    layout->atlas     = LoadRenderTexture(atlasCell * ATLAS_COLUMNS,
+                            atlasCell * ((ATLAS_TILES + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS));
+
+    SetTextureFilter(layout->atlas.texture, FILTER_BILINEAR);
+
+    BeginTextureMode(layout->atlas);
+    ClearBackground(BLANK);
+
+    for (int i = 0; i < ATLAS_TILES; i++)
+    {
+        Rectangle rec = {
+            (i % ATLAS_COLUMNS) * atlasCell + ATLAS_PADDING,
+            (i / ATLAS_COLUMNS) * atlasCell + ATLAS_PADDING,
+            tileSize, tileSize
+        };
+
+        if (i == 0)
+        {
+            DrawRoundedRectangleRec(rec, tileSize * 0.05, COLOR_CELL);
+            continue;
+        }
+
+        int font = (i < 10) ? tileSize * 0.5: tileSize * 0.4;
+        const TextLayout *label = GetNumberLayout(NULL, font, 2u << (i - 1));
+
+        // Center a tile value text position
+        Vector2 vector = (Vector2) {
+            rec.x + (rec.height * 0.5) - label->extent.x * 0.5,
+            rec.y + (rec.width * 0.5) - (font * 0.5)
+        };
+
+        // Define a tile value text color
+        Color color = (i <= 2) ? COLOR_GREY : COLOR_WHITE;
+
+        DrawRoundedRectangleRec(rec, tileSize * 0.05, NumToColor(i));
+        DrawText(label->text, vector.x, vector.y, font, color);
+    }
+
+    EndTextureMode();
+}
+
+static void DrawAtlasTile(const BoardLayout *layout, int index, Rectangle rec)
+{
+    int cell = layout->atlasCell;
+    float size = layout->tileSize;
+
+    // Render textures are stored upside down, the negative height flips them back
+    Rectangle source = {
+        (index % ATLAS_COLUMNS) * cell + ATLAS_PADDING,
+        layout->atlas.texture.height - (index / ATLAS_COLUMNS) * cell - ATLAS_PADDING - size,
+        size, -size
+    };
+
+    DrawTexturePro(layout->atlas.texture, source, rec, (Vector2){ 0, 0 }, 0, WHITE);
 }
 
 static void ProcessPhisics(Board *board)
@@ -242,58 +353,44 @@ static void ProcessPhisics(Board *board)
     case ANIMATION_MOVE:
 
         /*
-         * Update tiles move animation and add new tile to the grid.
+         * Update tiles move animation and show the new tile.
          * Applies only if the grid tiles was moved.
          */
 
-        if (++board->moveFrames > ANIMATION_MOVE_FRAMES)
+        if ((board->moveTime += GAME_STEP_TIME) >= ANIMATION_MOVE_TIME)
         {
-            board->moveFrames = 0;
-            board->animation  = ANIMATION_APPEAR;
+            board->moveTime  = 0;
+            board->animation = ANIMATION_APPEAR;
 
-            for (int i = 0; i < GRID_SIZE; i++)
+            for (int i = 0; i < board->grid.size*board->grid.size; i++)
             {
-                Tile *tile = &board->grid[i];
+                Tile *tile = &board->tiles[i];
 
                 /*
                  * Set value as oldValue if move animation was finished.
                  *
                  * Please note that tile will be draw with old value untile
-                 * move animation counter is less than moveFrames.
+                 * the move animation is over.
                  */
 
                 if (tile->oldValue != tile->value && board->animation == ANIMATION_APPEAR)
                     tile->oldValue = tile->value;
             }
-
-            AddTile(board);
         }
         break;
 
     case ANIMATION_APPEAR:
 
         /*
-         * Update tiles appear animation and save game state.
+         * Update tiles appear animation.
          * Applies after move animation.
          */
 
-        if (++board->appearFrames > ANIMATION_APPEAR_FRAMES)
+        if ((board->appearTime += GAME_STEP_TIME) >= ANIMATION_APPEAR_TIME)
         {
-            Notify(ADD_TILE_EVENT);
-
-            board->appearFrames = 0;
+            board->appearTime   = 0;
             board->animation    = ANIMATION_NONE;
             board->state        = BOARD_STATE_NONE;
-
-            if (!MoveIsAvailable(board))
-            {
-                /*
-                 * Check that game can be continue and display the game
-                 * over screen.
-                 */
-
-                Notify(GAME_OVER_EVENT);
-            }
         }
         break;
 
@@ -302,164 +399,36 @@ static void ProcessPhisics(Board *board)
     }
 }
 
-static Rectangle GetTileRec(const CellVector *v)
+static Rectangle GetTileRec(const BoardLayout *layout, const CellVector *v)
 {
     Rectangle rec;
+    int size = layout->size;
 
     // Add grid and tails offset
-    rec.x = boardRec.x + (tileSize * (v->x % SIZE));
-    rec.y = boardRec.y + (tileSize * (v->y % SIZE));
+    rec.x = layout->rec.x + (layout->tileSize * (v->x % size));
+    rec.y = layout->rec.y + (layout->tileSize * (v->y % size));
 
     // Add spacing offset
-    rec.x += spacing * ((v->x % SIZE) + 1);
-    rec.y += spacing * ((v->y % SIZE) + 1);
+    rec.x += layout->spacing * ((v->x % size) + 1);
+    rec.y += layout->spacing * ((v->y % size) + 1);
 
-    rec.width = rec.height = tileSize;
+    rec.width = rec.height = layout->tileSize;
 
     return rec;
 }
 
+// The tile is drawn once its old value is set, at the end of the move animation
 static void AddTile(Board *board)
 {
-    int i, j;
-    Tile *empty_grid[GRID_SIZE];
-
-    j = 0;
-    for (i = 0; i < GRID_SIZE; i++)
-    {
-        empty_grid[j] = NULL;
-        if (!board->grid[i].value) empty_grid[j++] = &board->grid[i];
-    }
-
-    if (j)
-    {
-        j = rand() % j;
-        empty_grid[j]->source = empty_grid[j];
-        empty_grid[j]->value = (rand() / RAND_MAX) < 0.9f ? 1 : 2;
-        empty_grid[j]->oldValue = empty_grid[j]->value;
-    }
-}
-
-static void Move(Board *board, int vx, int vy)
-{
-    int i, j;
-    int begin, end, inc;
-    int row, col;
+    int cell = SpawnGridTile(&board->grid, &board->random);
 
-    // Move Right and Down
-    if (vx == 1 || vy == 1)
-    {
-        begin = SIZE - 1;
-        end = -1;
-        inc = -1;
-    }
-    // Move Left and Up
-    else
-    {
-        begin = 0;
-        end = SIZE;
-        inc = 1;
-    }
+    board->lastSpawn = cell;
 
-    for (i = 0; i < SIZE; i++)
+    if (cell >= 0)
     {
-        for (j = begin; j != end; j += inc)
-        {
-            // Move by Y
-            if (vx == 0)
-            {
-                row = j;
-                col = i;
-            }
-            // Move by X
-            else if (vy == 0)
-            {
-                row = i;
-                col = j;
-            }
+        Tile *tile = &board->tiles[cell];
 
-            Tile *tile = &board->grid[row * SIZE + col];
-            tile->position = tile->oldPosition;
-            tile->source = NULL;
-            tile->oldValue = tile->value;
-        }
+        tile->source   = tile;
+        tile->value    = GetGridCell(&board->grid, cell);
     }
-
-    for (i = 0; i < SIZE; i++)
-    {
-        for (j = begin; j != end; j += inc)
-        {
-            int nextRow, nextCol;
-            Tile *tile, *next, *farthest;
-
-            // Move by Y
-            if (vx == 0)
-            {
-                row = i;
-                col = j;
-            }
-            // Move by X
-            else if (vy == 0)
-            {
-                row = j;
-                col = i;
-            }
-
-            tile = &board->grid[row * SIZE + col];
-            next = tile;
-
-            if (!tile->value) continue;
-
-            nextRow = row;
-            nextCol = col;
-
-            do
-            {
-                farthest = next;
-
-                nextRow += vx;
-                nextCol += vy;
-
-                if (nextRow < 0 || nextCol < 0 || nextRow > 3 || nextCol > 3)
-                    break;
-
-                next = &board->grid[nextRow * SIZE + nextCol];
-
-            } while (!next->value);
-
-            if (next != tile && tile->value == next->value && !next->source)
-            {
-                next->source     = tile;
-                tile->value      = 0;
-                tile->position   = next->oldPosition;
-                GetGame()->score = GetGame()->score + (2 << next->value);
-                next->value++;
-
-                if (next->value > GetGame()->max)
-                    GetGame()->max = next->value;
-
-                if (board->state < BOARD_STATE_MERGED)
-                    board->state = BOARD_STATE_MERGED;
-            }
-            else if (farthest != tile)
-            {
-                farthest->value = tile->value;
-                tile->value     = 0;
-                tile->position  = farthest->oldPosition;
-
-                if (board->state < BOARD_STATE_MOVED)
-                    board->state = BOARD_STATE_MOVED;
-            }
-        }
-    }
-}
-
-static bool GridIsFull(Board *board)
-{
-    for (int i = 0; i < GRID_SIZE; i++)
-    {
-        if (board->grid[i].value == 0)
-            return false;
-    }
-    return true;
 }
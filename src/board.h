@@ -3,9 +3,9 @@
 
 #include <stdbool.h>
 #include "raylib.h"
-
-#define SIZE 4
-#define GRID_SIZE (SIZE * SIZE)
+#include "bitboard.h"
+#include "grid.h"
+#include "random.h"
 
 //-------------------------------------------------------------------------------------------------
 // Types and Structures Definition
@@ -24,21 +24,39 @@ typedef struct _tile {
 } Tile;
 
 typedef struct {
-    unsigned int moveFrames;
-    unsigned int appearFrames;
+    Grid grid;               // Logical grid state of any size, the tiles below only animate it
+    uint64_t seed;           // Seed the game was started with, replays the same spawns
+    RandomGenerator random;  // Tile spawn generator, saved with the game
+    Direction lastMove;      // Last applied move, its score and the tile spawned after it
+    unsigned int lastScore;
+    int lastSpawn;
+    float moveTime;          // Seconds the move and the appear animations have run
+    float appearTime;
     enum { BOARD_STATE_NONE, BOARD_STATE_MOVED, BOARD_STATE_MERGED } state;
     enum { ANIMATION_NONE, ANIMATION_MOVE, ANIMATION_APPEAR } animation;
-    Tile grid[GRID_SIZE];
+    Tile tiles[GRID_MAX_CELLS];
 } Board;
 
+// Where and how big a board is drawn, every board on the screen has its own
+typedef struct {
+    Rectangle rec;
+    int size;                // Cells per side the layout is made for
+    float spacing;
+    float tileSize;
+    RenderTexture2D atlas;   // Every tile drawn once at the tile size
+    int atlasCell;           // Atlas cell size the atlas was baked for, 0 if not baked
+} BoardLayout;
+
 //-------------------------------------------------------------------------------------------------
 // Functions Declaration
 //-------------------------------------------------------------------------------------------------
-void InitBoard(Rectangle *rec);
+void InitBoard(BoardLayout *layout, Rectangle *rec, int size);
+void UnloadBoard(BoardLayout *layout);
 void UpdateBoard(Board *board);
-void DrawBoard(Board *board);
-void HandleBoardInput(Board *board);
-void ResetBoard(Board *board);
-bool MoveIsAvailable(Board *board);
+void DrawBoard(const BoardLayout *layout, const Board *board, float lag);
+bool ApplyBoardMove(Board *board, Direction direction);
+void ResetBoard(Board *board, int size, uint64_t seed);
+void RestoreBoard(Board *board, Bitboard cells);
+bool MoveIsAvailable(const Board *board);
 
 #endif  // BOARD_H
@@ -0,0 +1,43 @@
+#ifndef BYTEORDER_H
+#define BYTEORDER_H
+
+#include <stdint.h>
+
+/*
+ * Little-endian numbers of the save, history and cache files, written and
+ * read a byte at a time so the files don't depend on the host byte order.
+ * This module must not depend on raylib.
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+static inline void PutU32(unsigned char *data, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) data[i] = (unsigned char)(value >> (8*i));
+}
+
+static inline void PutU64(unsigned char *data, uint64_t value)
+{
+    for (int i = 0; i < 8; i++) data[i] = (unsigned char)(value >> (8*i));
+}
+
+static inline uint32_t GetU32(const unsigned char *data)
+{
+    uint32_t value = 0;
+
+    for (int i = 0; i < 4; i++) value |= (uint32_t)data[i] << (8*i);
+
+    return value;
+}
+
+static inline uint64_t GetU64(const unsigned char *data)
+{
+    uint64_t value = 0;
+
+    for (int i = 0; i < 8; i++) value |= (uint64_t)data[i] << (8*i);
+
+    return value;
+}
+
+#endif  // BYTEORDER_H
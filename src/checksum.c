@@ -0,0 +1,78 @@
+#include <pthread.h>
+#include "checksum.h"
+
+#define CRC32_POLYNOMIAL  0xEDB88320    // Reflected IEEE polynomial
+#define CRC32_SLICES      8             // Bytes consumed per step of the main loop
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static uint32_t crcTables[CRC32_SLICES][256];
+static pthread_once_t crcTablesOnce = PTHREAD_ONCE_INIT;
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static void InitCrcTables(void);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+/*
+ * Slicing-by-8 CRC-32, eight bytes per step. The font file and its atlas
+ * cache are checked on every launch, too much data for a bitwise loop. The
+ * tables are built on the first call from any thread. Continue a checksum
+ * by passing the previous result as the crc.
+ */
+uint32_t UpdateCrc32(uint32_t crc, const void *data, size_t size)
+{
+    const unsigned char *bytes = data;
+
+    pthread_once(&crcTablesOnce, InitCrcTables);
+
+    crc = ~crc;
+
+    // The bytes are combined one by one, the result doesn't depend on the host byte order
+    for (; size >= CRC32_SLICES; size -= CRC32_SLICES, bytes += CRC32_SLICES)
+    {
+        uint32_t low = crc ^ ((uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+                              (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24);
+
+        crc = crcTables[7][low & 0xFF] ^ crcTables[6][(low >> 8) & 0xFF] ^
+              crcTables[5][(low >> 16) & 0xFF] ^ crcTables[4][low >> 24] ^
+              crcTables[3][bytes[4]] ^ crcTables[2][bytes[5]] ^
+              crcTables[1][bytes[6]] ^ crcTables[0][bytes[7]];
+    }
+
+    while (size--) crc = (crc >> 8) ^ crcTables[0][(crc ^ *bytes++) & 0xFF];
+
+    return ~crc;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// The first table is the classic byte table, every next one advances the CRC by another byte
+static void InitCrcTables(void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+
+        for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (CRC32_POLYNOMIAL & -(crc & 1));
+
+        crcTables[0][i] = crc;
+    }
+
+    for (int slice = 1; slice < CRC32_SLICES; slice++)
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            uint32_t previous = crcTables[slice - 1][i];
+
+            crcTables[slice][i] = (previous >> 8) ^ crcTables[0][previous & 0xFF];
+        }
+    }
+}
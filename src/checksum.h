@@ -0,0 +1,12 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+uint32_t UpdateCrc32(uint32_t crc, const void *data, size_t size);    // CRC-32 (IEEE), starts at 0
+
+#endif  // CHECKSUM_H
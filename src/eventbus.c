@@ -0,0 +1,274 @@
+#include <stdlib.h>  // realloc, free
+#include <string.h>  // memmove
+#include "eventbus.h"
+
+#define INITIAL_CAPACITY  16
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static void *EventWorkerMain(void *arg);
+static bool AppendEvent(EventQueue *queue, const Event *event);
+static void DeliverEvent(EventBus *bus, const Event *event, bool worker);
+static void WaitWorkerIdle(EventBus *bus);
+static void UpdateMasks(EventBus *bus);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+void InitEventBus(EventBus *bus)
+{
+    *bus = (EventBus){ 0 };
+
+    pthread_mutex_init(&bus->lock, NULL);
+    pthread_cond_init(&bus->wake, NULL);
+    pthread_cond_init(&bus->idle, NULL);
+}
+
+// The worker runs the batches handed over before it stops, dispatch the queue before
+void UnloadEventBus(EventBus *bus)
+{
+    if (bus->threaded)
+    {
+        pthread_mutex_lock(&bus->lock);
+        bus->stop = true;
+        pthread_cond_broadcast(&bus->wake);
+        pthread_mutex_unlock(&bus->lock);
+
+        pthread_join(bus->thread, NULL);
+    }
+
+    pthread_cond_destroy(&bus->idle);
+    pthread_cond_destroy(&bus->wake);
+    pthread_mutex_destroy(&bus->lock);
+
+    free(bus->subscribers);
+    free(bus->queue.events);
+    free(bus->pending.events);
+
+    *bus = (EventBus){ 0 };
+}
+
+/*
+ * Deliver the events of the mask to the handler in the order they were
+ * published. A worker subscriber runs on the game thread if the worker
+ * thread can't be started. Returns -1 if the subscriber can't be stored.
+ */
+int Subscribe(EventBus *bus, unsigned int mask, EventHandler handler, void *context, bool worker)
+{
+    if (worker && !bus->threaded)
+    {
+        bus->threaded = (pthread_create(&bus->thread, NULL, EventWorkerMain, bus) == 0);
+    }
+
+    // The worker reads the subscribers while it runs a batch
+    WaitWorkerIdle(bus);
+
+    if (bus->count == bus->capacity)
+    {
+        int capacity = bus->capacity ? bus->capacity * 2 : INITIAL_CAPACITY;
+        Subscriber *subscribers = realloc(bus->subscribers, sizeof(Subscriber) * capacity);
+
+        if (!subscribers) return -1;
+
+        bus->subscribers = subscribers;
+        bus->capacity    = capacity;
+    }
+
+    worker = worker && bus->threaded;
+
+    bus->subscribers[bus->count++] = (Subscriber){ handler, context, mask, worker };
+
+    UpdateMasks(bus);
+
+    return 0;
+}
+
+int Unsubscribe(EventBus *bus, EventHandler handler, void *context)
+{
+    for (int i = 0; i < bus->count; i++)
+    {
+        if (bus->subscribers[i].handler == handler && bus->subscribers[i].context == context)
+        {
+            WaitWorkerIdle(bus);
+
+            // Keep the order, the subscribers get the events in the order they subscribed
+            memmove(&bus->subscribers[i], &bus->subscribers[i + 1],
+                    sizeof(Subscriber) * (bus->count - i - 1));
+            bus->count--;
+
+            UpdateMasks(bus);
+
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Queue the event for the next dispatch, it's dropped if no subscriber wants it
+void PublishEvent(EventBus *bus, const Event *event)
+{
+    if (!(bus->mask & EVENT_MASK(event->type)))
+    {
+        bus->stats.skipped++;
+        return;
+    }
+
+    if (!AppendEvent(&bus->queue, event))
+    {
+        bus->stats.dropped++;
+        return;
+    }
+
+    bus->stats.published++;
+}
+
+/*
+ * Run the game thread subscribers on the queued events and hand the batch
+ * over to the worker. The events published by the handlers meanwhile are
+ * delivered in the same batch.
+ */
+void DispatchEvents(EventBus *bus)
+{
+    if (bus->queue.count == 0) return;
+
+    for (int i = 0; i < bus->queue.count; i++)
+    {
+        Event event = bus->queue.events[i];    // A handler publishing may move the queue
+
+        DeliverEvent(bus, &event, false);
+    }
+
+    bus->stats.batches++;
+    if (bus->queue.count > bus->stats.maxBatch) bus->stats.maxBatch = bus->queue.count;
+
+    if (bus->workerMask)
+    {
+        pthread_mutex_lock(&bus->lock);
+
+        for (int i = 0; i < bus->queue.count; i++)
+        {
+            const Event *event = &bus->queue.events[i];
+
+            if (!(bus->workerMask & EVENT_MASK(event->type))) continue;
+
+            if (!AppendEvent(&bus->pending, event)) bus->stats.dropped++;
+        }
+
+        pthread_cond_signal(&bus->wake);
+        pthread_mutex_unlock(&bus->lock);
+    }
+
+    bus->queue.count = 0;
+}
+
+// Wait until the worker ran every batch handed over to it
+void FlushEventBus(EventBus *bus)
+{
+    WaitWorkerIdle(bus);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Take the pending batches at once and run them outside of the lock
+static void *EventWorkerMain(void *arg)
+{
+    EventBus *bus = arg;
+    EventQueue batch = { 0 };
+
+    pthread_mutex_lock(&bus->lock);
+
+    for (;;)
+    {
+        while (bus->pending.count == 0 && !bus->stop)
+        {
+            pthread_cond_wait(&bus->wake, &bus->lock);
+        }
+
+        if (bus->pending.count == 0) break;    // Stopped and nothing is left
+
+        // Swap the buffers, the game thread keeps appending to the empty one
+        EventQueue swap = bus->pending;
+
+        bus->pending = batch;
+        batch        = swap;
+        bus->busy    = true;
+
+        pthread_mutex_unlock(&bus->lock);
+
+        for (int i = 0; i < batch.count; i++) DeliverEvent(bus, &batch.events[i], true);
+
+        batch.count = 0;
+
+        pthread_mutex_lock(&bus->lock);
+
+        bus->busy = false;
+        if (bus->pending.count == 0) pthread_cond_broadcast(&bus->idle);
+    }
+
+    pthread_mutex_unlock(&bus->lock);
+
+    free(batch.events);
+
+    return NULL;
+}
+
+static bool AppendEvent(EventQueue *queue, const Event *event)
+{
+    if (queue->count == queue->capacity)
+    {
+        int capacity = queue->capacity ? queue->capacity * 2 : INITIAL_CAPACITY;
+        Event *events = realloc(queue->events, sizeof(Event) * capacity);
+
+        if (!events) return false;
+
+        queue->events   = events;
+        queue->capacity = capacity;
+    }
+
+    queue->events[queue->count++] = *event;
+
+    return true;
+}
+
+static void DeliverEvent(EventBus *bus, const Event *event, bool worker)
+{
+    for (int i = 0; i < bus->count; i++)
+    {
+        const Subscriber *subscriber = &bus->subscribers[i];
+
+        if (subscriber->worker == worker && (subscriber->mask & EVENT_MASK(event->type)))
+        {
+            subscriber->handler(event, subscriber->context);
+        }
+    }
+}
+
+static void WaitWorkerIdle(EventBus *bus)
+{
+    if (!bus->threaded) return;
+
+    pthread_mutex_lock(&bus->lock);
+
+    while (bus->pending.count > 0 || bus->busy)
+    {
+        pthread_cond_wait(&bus->idle, &bus->lock);
+    }
+
+    pthread_mutex_unlock(&bus->lock);
+}
+
+static void UpdateMasks(EventBus *bus)
+{
+    bus->mask       = 0;
+    bus->workerMask = 0;
+
+    for (int i = 0; i < bus->count; i++)
+    {
+        bus->mask |= bus->subscribers[i].mask;
+
+        if (bus->subscribers[i].worker) bus->workerMask |= bus->subscribers[i].mask;
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "grid.h"
+#include "journal.h"
+
+/*
+ * Game events with their payload. PublishEvent() only appends the event to
+ * the queue of the frame, DispatchEvents() delivers the whole queue in one
+ * batch at the end of the update, in the order the events were published.
+ * A subscriber runs on the game thread or, if asked for, on the worker
+ * thread of the bus, which gets every batch at once and never blocks the
+ * frame. The subscribers and the queue grow as needed, there is no cap.
+ * Subscribe and unsubscribe from the game thread only.
+ */
+
+#define EVENT_MASK(type)   (1u << (type))
+#define EVENT_MASK_ALL     (~0u)
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef enum { MOVE_EVENT, WIN_EVENT, GAME_OVER_EVENT, EVENT_TYPE_COUNT } EventType;
+
+typedef struct {
+    EventType type;
+    double time;                             // Monotonic time of the publication
+    Direction move;                          // MOVE_EVENT - the move, its merges and the spawn
+    unsigned int score;                      // Points of the move
+    int spawnCell;                           // -1 if no tile was spawned
+    unsigned int spawnValue;                 // Exponent of the spawned tile
+    int mergeCount;
+    unsigned char merges[GRID_MAX_CELLS];    // Cells the merged tiles ended up in
+    JournalSnapshot state;                   // Game state right after the event
+} Event;
+
+typedef void (*EventHandler)(const Event *event, void *context);
+
+typedef struct {
+    EventHandler handler;
+    void *context;                 // Passed back to the handler with every event
+    unsigned int mask;             // EVENT_MASK() of the types delivered
+    bool worker;                   // Runs on the worker thread
+} Subscriber;
+
+typedef struct {
+    Event *events;
+    int count;
+    int capacity;
+} EventQueue;
+
+typedef struct {
+    unsigned long long published;  // Events queued for a subscriber
+    unsigned long long skipped;    // Events no subscriber wanted
+    unsigned long long dropped;    // Events lost to a failed queue allocation
+    unsigned long long batches;    // Dispatches that delivered an event
+    int maxBatch;                  // Most events of a dispatch
+} EventStats;
+
+typedef struct {
+    Subscriber *subscribers;
+    int count;
+    int capacity;
+    unsigned int mask;             // Types any subscriber wants, the others aren't queued
+    unsigned int workerMask;       // Types a worker subscriber wants
+    EventQueue queue;              // Events of the current frame
+
+    pthread_t thread;              // Started with the first worker subscriber
+    pthread_mutex_t lock;
+    pthread_cond_t wake;           // Signaled when a batch was handed over or the bus stops
+    pthread_cond_t idle;           // Signaled when the worker finished the batches
+    EventQueue pending;            // Batches handed to the worker
+    bool threaded;                 // The worker thread runs
+    bool busy;                     // The worker runs the handlers
+    bool stop;
+    EventStats stats;
+} EventBus;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+void InitEventBus(EventBus *bus);
+void UnloadEventBus(EventBus *bus);
+int Subscribe(EventBus *bus, unsigned int mask, EventHandler handler, void *context, bool worker);
+int Unsubscribe(EventBus *bus, EventHandler handler, void *context);
+void PublishEvent(EventBus *bus, const Event *event);
+void DispatchEvents(EventBus *bus);
+void FlushEventBus(EventBus *bus);
+
+#endif  // EVENTBUS_H
@@ -0,0 +1,55 @@
+#if defined(_WIN32)
+#include <windows.h>    // MoveFileExA
+#include <io.h>         // _commit, _fileno
+#else
+#include <fcntl.h>      // open, O_RDONLY
+#include <unistd.h>     // fsync, close
+#endif
+
+#include <string.h>     // strrchr
+#include <sys/param.h>  // PATH_MAX
+#include "filesync.h"
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Flush the stream and sync the file to the disk
+int SyncFile(FILE *file)
+{
+    if (fflush(file) != 0) return -1;
+
+#if defined(_WIN32)
+    return _commit(_fileno(file));
+#else
+    return fsync(fileno(file));
+#endif
+}
+
+// Rename replacing the target, then make the rename itself durable
+int MoveFileOver(const char *from, const char *to)
+{
+#if defined(_WIN32)
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+#else
+    char directory[PATH_MAX];
+
+    if (rename(from, to) != 0) return -1;
+
+    snprintf(directory, sizeof(directory), "%s", to);
+
+    char *slash = strrchr(directory, '/');
+    if (slash) *slash = '\0';
+    else snprintf(directory, sizeof(directory), ".");
+
+    int fd = open(directory, O_RDONLY);
+
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+
+    return 0;
+#endif
+}
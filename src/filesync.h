@@ -0,0 +1,20 @@
+#ifndef FILESYNC_H
+#define FILESYNC_H
+
+#include <stdio.h>      // FILE
+
+/*
+ * Durable file replacement shared by the journal, the undo history and the
+ * font cache. A file is rewritten into a temporary file, synced and renamed
+ * over the old one, the rename is atomic so a crash leaves either the old or
+ * the new file.
+ * This module must not depend on raylib.
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+int SyncFile(FILE *file);
+int MoveFileOver(const char *from, const char *to);
+
+#endif  // FILESYNC_H
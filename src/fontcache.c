@@ -0,0 +1,223 @@
+#include <stdio.h>      // fopen, fread, fwrite, fclose, remove
+#include <stdlib.h>     // malloc, realloc, free
+#include <string.h>     // memcmp, memcpy, memmove
+#include <sys/param.h>  // PATH_MAX
+#include "byteorder.h"
+#include "checksum.h"
+#include "filesync.h"
+#include "fontcache.h"
+
+#define HEADER_SIZE     44
+#define GLYPH_SIZE      32
+#define CHECKSUM_SIZE   4
+#define MAX_FILE_BYTES  (64L << 20)     // Neither the fonts nor their caches get near it
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static const unsigned char magic[4] = { '2', 'F', 'N', 'C' };
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static unsigned char *ReadWholeFile(const char *path, long *size);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Hash the font file, reading it costs a fraction of rasterizing it
+int GetFontCacheKey(FontCacheKey *key, const char *fontPath, int fontSize, int glyphCount,
+                    int padding)
+{
+    long size = 0;
+    unsigned char *data = ReadWholeFile(fontPath, &size);
+
+    if (!data) return -1;
+
+    *key = (FontCacheKey){
+        .fontHash   = UpdateCrc32(0, data, size),
+        .fontBytes  = (uint32_t)size,
+        .fontSize   = fontSize,
+        .glyphCount = glyphCount,
+        .padding    = padding
+    };
+
+    free(data);
+
+    return 0;
+}
+
+/*
+ * Read the whole cache at once and take the pixels over in place. Returns -1
+ * if there is no cache, if it is damaged or if it was baked for another key.
+ */
+int LoadFontCache(FontCache *cache, const char *path, const FontCacheKey *key)
+{
+    long size = 0;
+    unsigned char *data = ReadWholeFile(path, &size);
+
+    *cache = (FontCache){ 0 };
+
+    if (!data) return -1;
+
+    long glyphBytes = (long)key->glyphCount * GLYPH_SIZE;
+    long pixelBytes = (size >= HEADER_SIZE) ? (long)GetU32(data + 40) : 0;
+
+    if (pixelBytes > size || size != HEADER_SIZE + glyphBytes + pixelBytes + CHECKSUM_SIZE ||
+        memcmp(data, magic, sizeof(magic)) != 0 ||
+        GetU32(data + 4) != FONT_CACHE_VERSION ||
+        GetU32(data + 8) != key->fontHash || GetU32(data + 12) != key->fontBytes ||
+        GetU32(data + 16) != (uint32_t)key->fontSize ||
+        GetU32(data + 20) != (uint32_t)key->glyphCount ||
+        GetU32(data + 24) != (uint32_t)key->padding ||
+        GetU32(data + size - CHECKSUM_SIZE) != UpdateCrc32(0, data, size - CHECKSUM_SIZE))
+    {
+        free(data);
+        return -1;
+    }
+
+    cache->glyphs = malloc(sizeof(FontCacheGlyph) * key->glyphCount);
+
+    if (!cache->glyphs)
+    {
+        free(data);
+        return -1;
+    }
+
+    cache->key        = *key;
+    cache->width      = (int)GetU32(data + 28);
+    cache->height     = (int)GetU32(data + 32);
+    cache->format     = (int)GetU32(data + 36);
+    cache->pixelBytes = (uint32_t)pixelBytes;
+
+    for (int i = 0; i < key->glyphCount; i++)
+    {
+        const unsigned char *glyph = data + HEADER_SIZE + i*GLYPH_SIZE;
+
+        cache->glyphs[i] = (FontCacheGlyph){
+            .value    = (int32_t)GetU32(glyph),
+            .x        = (int32_t)GetU32(glyph + 4),
+            .y        = (int32_t)GetU32(glyph + 8),
+            .width    = (int32_t)GetU32(glyph + 12),
+            .height   = (int32_t)GetU32(glyph + 16),
+            .offsetX  = (int32_t)GetU32(glyph + 20),
+            .offsetY  = (int32_t)GetU32(glyph + 24),
+            .advanceX = (int32_t)GetU32(glyph + 28)
+        };
+    }
+
+    // The pixels move to the beginning of the buffer, it becomes the image data
+    memmove(data, data + HEADER_SIZE + glyphBytes, pixelBytes);
+
+    unsigned char *pixels = realloc(data, pixelBytes ? pixelBytes : 1);
+
+    cache->pixels = pixels ? pixels : data;
+
+    return 0;
+}
+
+/*
+ * Write the cache to a temporary file and rename it over the old one, a
+ * crash leaves the old cache or none. Returns -1 if it can't be written.
+ */
+int SaveFontCache(const FontCache *cache, const char *path)
+{
+    const FontCacheKey *key = &cache->key;
+    long glyphBytes = (long)key->glyphCount * GLYPH_SIZE;
+    unsigned char *data = malloc(HEADER_SIZE + glyphBytes);
+    char temp[PATH_MAX];
+
+    if (!data) return -1;
+
+    memcpy(data, magic, sizeof(magic));
+    PutU32(data + 4, FONT_CACHE_VERSION);
+    PutU32(data + 8, key->fontHash);
+    PutU32(data + 12, key->fontBytes);
+    PutU32(data + 16, (uint32_t)key->fontSize);
+    PutU32(data + 20, (uint32_t)key->glyphCount);
+    PutU32(data + 24, (uint32_t)key->padding);
+    PutU32(data + 28, (uint32_t)cache->width);
+    PutU32(data + 32, (uint32_t)cache->height);
+    PutU32(data + 36, (uint32_t)cache->format);
+    PutU32(data + 40, cache->pixelBytes);
+
+    for (int i = 0; i < key->glyphCount; i++)
+    {
+        const FontCacheGlyph *glyph = &cache->glyphs[i];
+        unsigned char *record = data + HEADER_SIZE + i*GLYPH_SIZE;
+
+        PutU32(record, (uint32_t)glyph->value);
+        PutU32(record + 4, (uint32_t)glyph->x);
+        PutU32(record + 8, (uint32_t)glyph->y);
+        PutU32(record + 12, (uint32_t)glyph->width);
+        PutU32(record + 16, (uint32_t)glyph->height);
+        PutU32(record + 20, (uint32_t)glyph->offsetX);
+        PutU32(record + 24, (uint32_t)glyph->offsetY);
+        PutU32(record + 28, (uint32_t)glyph->advanceX);
+    }
+
+    unsigned char checksum[CHECKSUM_SIZE];
+    uint32_t crc = UpdateCrc32(0, data, HEADER_SIZE + glyphBytes);
+
+    PutU32(checksum, UpdateCrc32(crc, cache->pixels, cache->pixelBytes));
+
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+
+    FILE *file = fopen(temp, "wb");
+    int written = -1;
+
+    if (file)
+    {
+        written = (fwrite(data, HEADER_SIZE + glyphBytes, 1, file) == 1 &&
+                   fwrite(cache->pixels, cache->pixelBytes, 1, file) == 1 &&
+                   fwrite(checksum, CHECKSUM_SIZE, 1, file) == 1) ? 0 : -1;
+
+        if (fclose(file) != 0) written = -1;
+    }
+
+    free(data);
+
+    if (written == 0 && MoveFileOver(temp, path) != 0) written = -1;
+
+    if (written != 0) remove(temp);
+
+    return written;
+}
+
+void UnloadFontCache(FontCache *cache)
+{
+    free(cache->glyphs);
+    free(cache->pixels);
+
+    *cache = (FontCache){ 0 };
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// The file contents in a single read, NULL if the file can't be read
+static unsigned char *ReadWholeFile(const char *path, long *size)
+{
+    FILE *file = fopen(path, "rb");
+    unsigned char *data = NULL;
+
+    if (!file) return NULL;
+
+    if (fseek(file, 0, SEEK_END) == 0 && (*size = ftell(file)) > 0 &&
+        *size <= MAX_FILE_BYTES && fseek(file, 0, SEEK_SET) == 0)
+    {
+        data = malloc(*size);
+
+        if (data && fread(data, *size, 1, file) != 1)
+        {
+            free(data);
+            data = NULL;
+        }
+    }
+
+    fclose(file);
+
+    return data;
+}
@@ -0,0 +1,62 @@
+#ifndef FONTCACHE_H
+#define FONTCACHE_H
+
+#include <stdint.h>
+
+/*
+ * Baked font atlas cache. The first launch rasterizes the font and saves the
+ * glyph metrics and the atlas pixels, the next ones load them with a single
+ * read instead of rasterizing the glyphs again. The cache is keyed on the
+ * CRC-32 and the size of the font file and on the rasterization parameters,
+ * a cache baked from another font file or at another size is a miss.
+ * This module must not depend on raylib.
+ *
+ * Layout (all numbers little-endian):
+ *   header    "2FNC" magic, version u32, font CRC-32 u32, font bytes u32, font size u32,
+ *             glyph count u32, padding u32, atlas width u32, height u32, format u32,
+ *             pixel bytes u32
+ *   glyphs    codepoint, x, y, width, height, offset x, offset y, advance x - 8 x i32 each
+ *   pixels    the atlas image data as is
+ *   checksum  CRC-32 of everything before it u32
+ */
+
+#define FONT_CACHE_VERSION  1
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    uint32_t fontHash;             // CRC-32 of the font file
+    uint32_t fontBytes;
+    int fontSize;
+    int glyphCount;
+    int padding;                   // Pixels around every glyph of the atlas
+} FontCacheKey;
+
+typedef struct {
+    int value;                     // Codepoint
+    int x, y, width, height;       // Rectangle of the glyph in the atlas
+    int offsetX, offsetY;
+    int advanceX;
+} FontCacheGlyph;
+
+typedef struct {
+    FontCacheKey key;
+    FontCacheGlyph *glyphs;        // key.glyphCount entries
+    unsigned char *pixels;         // Atlas image data, allocated with malloc()
+    uint32_t pixelBytes;
+    int width;
+    int height;
+    int format;                    // Pixel format of the image data
+} FontCache;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+int GetFontCacheKey(FontCacheKey *key, const char *fontPath, int fontSize, int glyphCount,
+                    int padding);
+int LoadFontCache(FontCache *cache, const char *path, const FontCacheKey *key);
+int SaveFontCache(const FontCache *cache, const char *path);
+void UnloadFontCache(FontCache *cache);
+
+#endif  // FONTCACHE_H
@@ -1,133 +1,444 @@
-#include <stdio.h>      // fopen, fread, fwrite, fclose, fseek, SEEK_SET
+#include <stdio.h>      // FILE
 #include <sys/param.h>  // PATH_MAX
 #include "raylib.h"
 #include "game.h"
-#include "observer.h"
-#include "resources.h"
+#include "profiler.h"
+#include "redraw.h"
+#include "timer.h"
 #include "utils.h"
 
-//-------------------------------------------------------------------------------------------------
-// Local Variables Definition
-//-------------------------------------------------------------------------------------------------
-static Game game;
-static FILE *file;
+/*
+ * Durability versus the cost per save, see the journal_append benchmarks.
+ * The saves are written on the save thread, so syncing every move doesn't
+ * stall the frames.
+ */
+#define SAVE_SYNC_POLICY  (SyncPolicy){ SYNC_EVERY_MOVE, 0, 0.0 }
 
 //-------------------------------------------------------------------------------------------------
 // Local Functions Declaration
 //-------------------------------------------------------------------------------------------------
-static int SaveGame(void);
-static int LoadGame(void);
+static void SaveGame(Game *game);
+static int LoadGame(Game *game);
+static void MakeSnapshot(const Game *game, JournalSnapshot *snapshot);
+static void ApplySnapshot(Game *game, const JournalSnapshot *snapshot);
+static bool StepHistory(Game *game, bool redo);
 
 //-------------------------------------------------------------------------------------------------
-// Local Observer Functions Declaration
+// Local Event Handlers Declaration
 //-------------------------------------------------------------------------------------------------
-static void SavingObserver(Event);
-static void GameWinObserver(Event);
-static void GameOverObserver(Event);
+static void SavingHandler(const Event *event, void *context);
+static void StatsHandler(const Event *event, void *context);
 
 //-------------------------------------------------------------------------------------------------
 // Functions Definition
 //-------------------------------------------------------------------------------------------------
-Game * GetGame(void) { return &game; }
-
-void NewGame(void)
+void NewGame(Game *game)
 {
     TraceLog(LOG_INFO, "Start new game");
 
-    GetGame()->score = 0;
-    GetGame()->moves = 0;
-    GetGame()->state = GAME_PLAY;
+    DispatchEvents(&game->events);    // The moves before belong to the previous game
+
+    game->score    = 0;
+    game->moves    = 0;
+    game->state    = GAME_PLAY;
+    game->overTime = 0;
+
+    ResetBoard(&game->board, game->size, GetTimeSeed());
+
+    if (game->persistent)
+    {
+        ResetHistory(&game->history, GridToBitboard(&game->board.grid));
+        SaveGame(game);
+    }
+}
+
+/*
+ * A 4x4 game with a save path resumes the saved game. The other sizes are
+ * there to stress the engine and the renderer, they always start a new game,
+ * aren't saved and can't be undone. A NULL save path makes a 4x4 game of
+ * the same kind, the sessions that must not share the save use it.
+ */
+void InitGame(Game *game, int size, const char *savePath, const char *historyPath)
+{
+    InitMoveTables();          // Build the move lookup tables before any board is touched
+
+    *game = (Game){ 0 };
+
+    game->size        = size;
+    game->persistent  = (size == BITBOARD_SIZE) && savePath;
+    game->historyPath = historyPath;
 
-    ResetBoard(&GetGame()->board);
-    SaveGame();
+    InitEventBus(&game->events);
+
+    if (!game->persistent)
+    {
+        TraceLog(LOG_INFO, "Board %dx%d isn't saved and can't be undone", size, size);
+
+        NewGame(game);
+    }
+    else
+    {
+        if (!InitHistory(&game->history, HISTORY_CAPACITY))
+        {
+            TraceLog(LOG_WARNING, "Can't allocate the undo history, undo is disabled");
+        }
+
+        if (OpenJournal(&game->journal, savePath, JOURNAL_SNAPSHOT_INTERVAL) != 0)
+        {
+            TraceLog(LOG_WARNING, "Can't open save file %s", savePath);
+        }
+
+        SetJournalSyncPolicy(&game->journal, SAVE_SYNC_POLICY);
+
+        bool loaded = (LoadGame(game) == 0) && MoveIsAvailable(&game->board);
+
+        if (!InitSaver(&game->saver, &game->journal))
+        {
+            TraceLog(LOG_WARNING, "Can't start the save thread, saving synchronously");
+        }
+
+        if (!loaded)
+        {
+            NewGame(game);
+        }
+        else if (LoadHistory(&game->history, historyPath, GridToBitboard(&game->board.grid)) != 0)
+        {
+            // Missing or doesn't match the save
+            ResetHistory(&game->history, GridToBitboard(&game->board.grid));
+        }
+
+        Subscribe(&game->events, EVENT_MASK(MOVE_EVENT) | EVENT_MASK(GAME_OVER_EVENT),
+                  SavingHandler, game, false);
+    }
 }
 
-void InitGame(void)
+void UnloadGame(Game *game)
 {
-    MakeSaveDir(saveDirPath);  // Create save data directory if not exist
+    TraceLog(LOG_DEBUG, "Unload Game");
+
+    DispatchEvents(&game->events);    // Deliver the last frame, the saves are among them
+
+    EventStats events = game->events.stats;
+
+    UnloadEventBus(&game->events);    // Waits for the worker subscribers
+
+    TraceLog(LOG_INFO, "Events: %llu published, %llu skipped, %llu dropped, %llu batches, "
+             "%d at most", events.published, events.skipped, events.dropped, events.batches,
+             events.maxBatch);
 
-    if ((file = fopen(saveFilePath, "rb+")) == NULL)
+    if (game->stats.tracked)
     {
-        file = fopen(saveFilePath, "wb+");
+        TraceLog(LOG_INFO, "Stats: %llu moves, %llu merges, %llu fours spawned, best move %u "
+                 "points", game->stats.moves, game->stats.merges, game->stats.fours,
+                 game->stats.bestMove);
     }
 
-    if (LoadGame() != 0 || !MoveIsAvailable(&GetGame()->board))
+    if (!game->persistent) return;
+
+    FlushSaver(&game->saver);     // Write the pending saves before the file is closed
+
+    SaveStats stats = GetSaveStats(&game->saver);
+
+    UnloadSaver(&game->saver);
+
+    TraceLog(LOG_INFO, "Saves: %llu queued, %llu coalesced, %llu written, %llu failed, "
+             "worst latency %.2f ms", stats.queued, stats.coalesced, stats.written, stats.failed,
+             stats.maxLatency * 1000);
+
+    CloseJournal(&game->journal);
+    TraceLog(LOG_INFO, "Close save file (%llu bytes written)", game->journal.written);
+
+    if (game->history.capacity && SaveHistory(&game->history, game->historyPath) != 0)
     {
-        NewGame();
+        TraceLog(LOG_WARNING, "Can't save the undo history to %s", game->historyPath);
     }
 
-    AttachObserver(*SavingObserver);
-    AttachObserver(*GameWinObserver);
-    AttachObserver(*GameOverObserver);
+    UnloadHistory(&game->history);
 }
 
-void UnloadGame(void)
+/*
+ * Queue every arrow pressed this frame and apply the queued moves to the
+ * logical board at once, a move never waits for the animation of the
+ * previous one, the animation is fast-forwarded instead.
+ */
+void HandleGameInput(Game *game)
 {
-    TraceLog(LOG_DEBUG, "Unload Game");
+    double now = GetMonotonicTime();
+    InputEvent event;
 
-    DetachObserver(*SavingObserver);
-    DetachObserver(*GameWinObserver);
-    DetachObserver(*GameOverObserver);
+    if (IsKeyPressed(KEY_RIGHT)) PushInput(&game->input, MOVE_RIGHT, now);
+    if (IsKeyPressed(KEY_LEFT))  PushInput(&game->input, MOVE_LEFT, now);
+    if (IsKeyPressed(KEY_UP))    PushInput(&game->input, MOVE_UP, now);
+    if (IsKeyPressed(KEY_DOWN))  PushInput(&game->input, MOVE_DOWN, now);
 
-    fclose(file);
-    TraceLog(LOG_INFO, "Close save file");
+    if (game->inputScript)
+    {
+        FeedInputScript(game->inputScript, &game->input, now);
+
+        // The loop would otherwise sleep on the input events past the next scripted move
+        if (game->inputScript->next < game->inputScript->count) RequestRedraw();
+    }
+
+    // The moves after a game over or a win wait for the game to go on
+    while (game->state == GAME_PLAY && PopInput(&game->input, &event))
+    {
+        MoveGame(game, event.move);
+        RecordInputApplied(&game->input, &event, GetMonotonicTime());
+    }
 }
 
-//-------------------------------------------------------------------------------------------------
-// Local Functions Definition
-//-------------------------------------------------------------------------------------------------
-static int SaveGame(void)
+/*
+ * Apply the move as if it was entered by the player, count it to the score
+ * and change the game state right away, the next queued move sees it. The
+ * saving, the stats and the sounds get the events of the move at the end of
+ * the update. Returns false if no tile moved.
+ */
+bool MoveGame(Game *game, Direction direction)
 {
-    fseek(file, 0, SEEK_SET);
+    Board *board = &game->board;
+
+    if (!ApplyBoardMove(board, direction)) return false;
+
+    game->moves++;
 
-    if (fwrite(GetGame(), sizeof(Game), 1, file) == 0)
+    if (board->lastScore > 0)
     {
-        TraceLog(LOG_WARNING, "Error writing file");
-        return -1;
+        game->score = game->score + board->lastScore;
+        game->best  = MAX(game->best, game->score);
+        game->max   = MAX(game->max, GetGridMaxExponent(&board->grid));
     }
-    TraceLog(LOG_INFO, "Game was saved successfully");
+
+    Event event = {
+        .type       = MOVE_EVENT,
+        .time       = GetMonotonicTime(),
+        .move       = direction,
+        .score      = board->lastScore,
+        .spawnCell  = board->lastSpawn,
+        .spawnValue = (board->lastSpawn >= 0) ? GetGridCell(&board->grid, board->lastSpawn) : 0,
+    };
+
+    // The merged tiles are their own source, like the spawned one
+    for (int i = 0; i < board->grid.size*board->grid.size; i++)
+    {
+        if (board->tiles[i].source && i != board->lastSpawn) event.merges[event.mergeCount++] = i;
+    }
+
+    // The 2048 tile shows the win screen once
+    bool won = !game->win && game->max == 11;
+
+    if (won)
+    {
+        game->win   = true;
+        game->state = GAME_WIN;
+    }
+
+    // Check that game can be continue and display the game over screen
+    bool over = !MoveIsAvailable(board);
+
+    if (over) game->state = GAME_OVER;
+
+    MakeSnapshot(game, &event.state);
+    PublishEvent(&game->events, &event);
+
+    event.type = WIN_EVENT;
+    if (won) PublishEvent(&game->events, &event);
+
+    event.type = GAME_OVER_EVENT;
+    if (over) PublishEvent(&game->events, &event);
+
+    return true;
+}
+
+// Count the moves of the game on the worker thread of the bus, logged when the game is unloaded
+void TrackGameStats(Game *game)
+{
+    if (game->stats.tracked) return;
+
+    game->stats.tracked = (Subscribe(&game->events, EVENT_MASK(MOVE_EVENT), StatsHandler, game,
+                                     true) == 0);
+}
+
+SaveStats GetGameSaveStats(Game *game)
+{
+    return GetSaveStats(&game->saver);
+}
+
+// Take back the last move, the animation of the move is cut short
+bool UndoGame(Game *game)
+{
+    return StepHistory(game, false);
+}
+
+// Apply again the move that was taken back
+bool RedoGame(Game *game)
+{
+    return StepHistory(game, true);
+}
+
+// Write the game state as a new journal to the beginning of the stream
+int WriteGame(FILE *stream, const Game *game)
+{
+    JournalSnapshot snapshot;
+
+    MakeSnapshot(game, &snapshot);
+
+    return (WriteJournal(stream, &snapshot) < 0) ? -1 : 0;
+}
+
+// Replay the journal in the stream and rebuild the board tiles
+int ReadGame(FILE *stream, Game *game)
+{
+    JournalSnapshot snapshot;
+    long end;
+
+    if (ReplayJournal(stream, &snapshot, &end) < 0) return -1;
+
+    ApplySnapshot(game, &snapshot);
+
     return 0;
 }
 
-static int LoadGame(void)
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+// Start the journal over from the current state
+static void SaveGame(Game *game)
+{
+    PROFILE_BEGIN(PROFILE_SAVE);
+
+    SaveRequest request = { .type = SAVE_START, .submitted = GetMonotonicTime() };
+
+    MakeSnapshot(game, &request.state);
+    SubmitSave(&game->saver, &request);
+
+    PROFILE_END(PROFILE_SAVE);
+
+    TraceLog(LOG_INFO, "Game save was queued");
+}
+
+static int LoadGame(Game *game)
 {
-    if (fread(GetGame(), sizeof(Game), 1, file) == 0)
+    JournalSnapshot snapshot;
+    int replayed = RecoverJournal(&game->journal, &snapshot);
+
+    if (replayed < 0)
     {
-        TraceLog(LOG_WARNING, "Error reading file");
+        // Never overwrite a damaged save with the new game silently
+        if (BackupJournal(&game->journal) > 0)
+        {
+            TraceLog(LOG_WARNING, "Save file is damaged, it was moved to %s.bak",
+                     game->journal.path);
+        }
         return -1;
     }
-    TraceLog(LOG_INFO, "Game was loaded successfully");
+
+    ApplySnapshot(game, &snapshot);
+
+    TraceLog(LOG_INFO, "Game was loaded successfully (%d moves replayed)", replayed);
     return 0;
 }
 
-// Save tha Game if tiles in the Board were moved or merged.
-static void SavingObserver(Event event)
+static void MakeSnapshot(const Game *game, JournalSnapshot *snapshot)
 {
-    if (event == ADD_TILE_EVENT || event == GAME_OVER_EVENT)
-    {
-        SaveGame();
-    }
+    snapshot->cells  = GridToBitboard(&game->board.grid);
+    snapshot->seed   = game->board.seed;
+    snapshot->random = game->board.random;
+    snapshot->score  = game->score;
+    snapshot->best   = game->best;
+    snapshot->moves  = game->moves;
+    snapshot->max    = game->max;
+    snapshot->win    = game->win;
+}
+
+static void ApplySnapshot(Game *game, const JournalSnapshot *snapshot)
+{
+    game->score        = snapshot->score;
+    game->best         = snapshot->best;
+    game->moves        = snapshot->moves;
+    game->max          = snapshot->max;
+    game->win          = snapshot->win;
+    game->state        = GAME_PLAY;
+    game->board.seed   = snapshot->seed;
+    game->board.random = snapshot->random;
+
+    RestoreBoard(&game->board, snapshot->cells);
 }
 
 /*
- * Check that game is won and display a specified screen,
- * this screen should be displayed once when the best tile
- * score is 2048.
+ * Move through the history and write the new state as a journal snapshot, so
+ * the recovery starts from it. A move that still animates is cut short, the
+ * board is restored without animation. The spawn generator isn't rewound, a
+ * move repeated after an undo may spawn a different tile.
  */
-static void GameWinObserver(Event event)
+static bool StepHistory(Game *game, bool redo)
 {
-    if (event == ADD_TILE_EVENT && !GetGame()->win && GetGame()->max == 11)
+    Bitboard cells;
+    uint32_t score;
+
+    DispatchEvents(&game->events);    // The history gets the moves at the dispatch
+
+    History *history = &game->history;
+
+    if (redo ? !RedoHistory(history, &cells, &score) : !UndoHistory(history, &cells, &score))
     {
-        GetGame()->win   = true;
-        GetGame()->state = GAME_WIN;
+        return false;
     }
+
+    game->score = redo ? game->score + score : game->score - score;
+    game->moves = redo ? game->moves + 1 : game->moves - 1;
+    game->state = GAME_PLAY;
+    game->overTime = 0;
+
+    RestoreBoard(&game->board, cells);
+
+    SaveRequest request = { .type = SAVE_SNAPSHOT, .submitted = GetMonotonicTime() };
+
+    MakeSnapshot(game, &request.state);
+    SubmitSave(&game->saver, &request);
+
+    return true;
 }
 
-// Change the Game state on Game Over.
-static void GameOverObserver(Event event)
+/*
+ * Queue the move and the spawned tile for the journal, the full state is
+ * only written every JOURNAL_SNAPSHOT_INTERVAL moves and on the game over.
+ * The save thread does the writing, the frame never waits for the disk.
+ * The state comes with the event, the game may have moved on since.
+ */
+static void SavingHandler(const Event *event, void *context)
 {
-    if (event == GAME_OVER_EVENT && GetGame()->state != GAME_OVER)
+    Game *game = context;
+    SaveRequest request = { .submitted = event->time, .state = event->state };
+
+    if (event->type == MOVE_EVENT && event->spawnCell >= 0)
+    {
+        PushHistory(&game->history, event->state.cells, event->score);
+
+        request.type = SAVE_MOVE;
+        request.move = (JournalMove){ event->move, event->spawnCell, event->spawnValue };
+    }
+    else if (event->type == GAME_OVER_EVENT)
     {
-        GetGame()->state = GAME_OVER;
+        request.type = SAVE_SNAPSHOT;
     }
+    else
+    {
+        return;
+    }
+
+    PROFILE_BEGIN(PROFILE_SAVE);
+    SubmitSave(&game->saver, &request);
+    PROFILE_END(PROFILE_SAVE);
+}
+
+// Runs on the worker thread, only the stats are written here
+static void StatsHandler(const Event *event, void *context)
+{
+    GameStats *stats = &((Game *)context)->stats;
+
+    stats->moves++;
+    stats->merges += event->mergeCount;
+    stats->fours  += (event->spawnValue == 2);
+
+    if (event->score > stats->bestMove) stats->bestMove = event->score;
 }
@@ -2,11 +2,45 @@
 #define GAME_H
 
 #include <stdbool.h>
+#include <stdio.h>  // FILE
 #include "board.h"
+#include "eventbus.h"
+#include "history.h"
+#include "input.h"
+#include "journal.h"
+#include "saver.h"
+#include "solver.h"
+
+#define GAME_STEP_TIME  (1.0f/120)    // Seconds of a fixed logic step
 
 //-------------------------------------------------------------------------------------------------
 // Types and Structures Definition
 //-------------------------------------------------------------------------------------------------
+
+// Counted from the move events on the worker thread of the bus
+typedef struct {
+    bool tracked;                  // Set once TrackGameStats() subscribed
+    unsigned long long moves;
+    unsigned long long merges;
+    unsigned long long fours;      // Spawned 4 tiles
+    unsigned int bestMove;         // Most points of a single move
+} GameStats;
+
+// The solver of a 4x4 game, the gameplay screen sets it up for the hints and the autoplay
+typedef struct {
+    Solver solver;
+    bool ready;                    // Only a 4x4 game has a solver
+    bool autoplay;                 // The solver plays the game instead of the player
+    bool hintVisible;
+    Direction hintMove;
+    Bitboard hintBoard;            // Board the hint was searched for
+} GameAssist;
+
+/*
+ * One game session with everything it owns, a process can run any number of
+ * them side by side. Only a 4x4 game with a save path is persistent, the
+ * others keep no journal, save thread or undo history.
+ */
 typedef struct {
     unsigned int score;      // Current score value
     unsigned int best;       // Best score value
@@ -14,15 +48,37 @@ typedef struct {
     unsigned int max;        // Highest tile value
     bool win;                // Set true if tile 2048 was achieved
     enum { GAME_PLAY, GAME_WIN, GAME_OVER } state;
+    float overTime;          // Seconds the game over animation has run
     Board board;
+
+    int size;                // Cells per side of the new games
+    bool persistent;         // Saved and has the undo history
+    const char *historyPath;
+    Journal journal;
+    Saver saver;             // Owns the journal writes once the game is loaded
+    History history;
+
+    InputQueue input;        // Moves entered this frame, applied before the frame ends
+    InputScript *inputScript;    // Synthetic moves, NULL without a script
+    EventBus events;         // Moves, wins and game overs, dispatched at the end of the update
+    GameStats stats;
+    GameAssist assist;
 } Game;
 
 //-------------------------------------------------------------------------------------------------
 // Functions Declaration
 //-------------------------------------------------------------------------------------------------
-Game * GetGame(void);
-void NewGame(void);
-void InitGame(void);
-void UnloadGame(void);
+void NewGame(Game *game);
+void InitGame(Game *game, int size, const char *savePath, const char *historyPath);
+void UnloadGame(Game *game);
+void HandleGameInput(Game *game);
+bool MoveGame(Game *game, Direction direction);
+void TrackGameStats(Game *game);
+SaveStats GetGameSaveStats(Game *game);
+bool UndoGame(Game *game);
+bool RedoGame(Game *game);
+
+int WriteGame(FILE *stream, const Game *game);
+int ReadGame(FILE *stream, Game *game);
 
 #endif  //GAME_H
@@ -0,0 +1,160 @@
+#include <math.h>     // acosf, cosf, sinf, ceilf
+#include <stdbool.h>
+#include "geometry.h"
+
+#define RADIUS_TABLE_SIZE   512    // Segment counts of the radii 0 to 511 pixels
+#define MAX_ARC_ERROR       0.5f   // Pixels between the arc and its segments
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static GeometryVertex cornerTables[GEOMETRY_MAX_SEGMENTS + 1][GEOMETRY_MAX_SEGMENTS + 1];
+static bool cornerTableReady[GEOMETRY_MAX_SEGMENTS + 1];
+
+static unsigned char radiusSegments[RADIUS_TABLE_SIZE];
+static bool radiusSegmentsReady;
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static void BuildRadiusSegments(void);
+static inline GeometryVertex *PutQuad(GeometryVertex *v, GeometryVertex a, GeometryVertex b,
+                                      GeometryVertex c, GeometryVertex d);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Fewest segments of a quarter circle of the radius within the arc error
+int GetCornerSegments(float radius)
+{
+    if (!radiusSegmentsReady) BuildRadiusSegments();
+
+    if (radius < 0) radius = 0;
+
+    return (radius < RADIUS_TABLE_SIZE - 1) ? radiusSegments[(int)ceilf(radius)]
+                                            : GEOMETRY_MAX_SEGMENTS;
+}
+
+// Cosine and sine of the segments + 1 angles from 0 to 90 degrees
+const GeometryVertex * GetCornerTable(int segments)
+{
+    if (segments < 1) segments = 1;
+    if (segments > GEOMETRY_MAX_SEGMENTS) segments = GEOMETRY_MAX_SEGMENTS;
+
+    if (!cornerTableReady[segments])
+    {
+        for (int i = 0; i <= segments; i++)
+        {
+            float angle = (float)M_PI*0.5f*i/segments;
+
+            cornerTables[segments][i] = (GeometryVertex){ cosf(angle), sinf(angle) };
+        }
+
+        cornerTableReady[segments] = true;
+    }
+
+    return cornerTables[segments];
+}
+
+/*
+ * Write the quads of the rectangle: the vertical middle part, the left and
+ * the right parts and a fan of every corner with two segments per quad.
+ * Returns the number of vertices, at most GEOMETRY_MAX_VERTICES.
+ */
+int BuildRoundedRectangle(float x, float y, float width, float height, float radius,
+                          GeometryVertex *vertices)
+{
+    GeometryVertex *v = vertices;
+
+    // Make sure the rectangle is at least as wide and tall as the rounded corners
+    if (width < radius*2) width = radius*2;
+    if (height < radius*2) height = radius*2;
+
+    float left   = x + radius;
+    float right  = x + width - radius;
+    float top    = y + radius;
+    float bottom = y + height - radius;
+
+    v = PutQuad(v, (GeometryVertex){ left, y }, (GeometryVertex){ left, y + height },
+                (GeometryVertex){ right, y + height }, (GeometryVertex){ right, y });
+    v = PutQuad(v, (GeometryVertex){ x, top }, (GeometryVertex){ x, bottom },
+                (GeometryVertex){ left, bottom }, (GeometryVertex){ left, top });
+    v = PutQuad(v, (GeometryVertex){ right, top }, (GeometryVertex){ right, bottom },
+                (GeometryVertex){ x + width, bottom }, (GeometryVertex){ x + width, top });
+
+    int segments = GetCornerSegments(radius);
+    const GeometryVertex *table = GetCornerTable(segments);
+
+    // Corners clockwise from the bottom right one, every one turns the table by 90 degrees
+    const GeometryVertex centers[4] = {
+        { right, bottom }, { left, bottom }, { left, top }, { right, top }
+    };
+
+    for (int corner = 0; corner < 4; corner++)
+    {
+        GeometryVertex arc[GEOMETRY_MAX_SEGMENTS + 1];
+        GeometryVertex center = centers[corner];
+
+        for (int i = 0; i <= segments; i++)
+        {
+            float c = table[i].x*radius;
+            float s = table[i].y*radius;
+
+            switch (corner)
+            {
+            case 0: arc[i] = (GeometryVertex){ center.x + c, center.y + s }; break;
+            case 1: arc[i] = (GeometryVertex){ center.x - s, center.y + c }; break;
+            case 2: arc[i] = (GeometryVertex){ center.x - c, center.y - s }; break;
+            default: arc[i] = (GeometryVertex){ center.x + s, center.y - c }; break;
+            }
+        }
+
+        // Walk the arc backwards so the quads wind the same way as the rectangles
+        for (int i = segments; i > 0; i -= 2)
+        {
+            int next = (i >= 2) ? i - 2 : 0;
+
+            v = PutQuad(v, center, arc[i], arc[i - 1], arc[next]);
+        }
+    }
+
+    return (int)(v - vertices);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+static void BuildRadiusSegments(void)
+{
+    for (int radius = 0; radius < RADIUS_TABLE_SIZE; radius++)
+    {
+        int segments = 1;
+
+        // The sagitta of a segment of the angle a is radius*(1 - cos(a/2))
+        if (radius > MAX_ARC_ERROR)
+        {
+            float angle = 2*acosf(1 - MAX_ARC_ERROR/radius);
+
+            segments = (int)ceilf((float)M_PI*0.5f/angle);
+        }
+
+        if (segments < 1) segments = 1;
+        if (segments > GEOMETRY_MAX_SEGMENTS) segments = GEOMETRY_MAX_SEGMENTS;
+
+        radiusSegments[radius] = segments;
+    }
+
+    radiusSegmentsReady = true;
+}
+
+static inline GeometryVertex *PutQuad(GeometryVertex *v, GeometryVertex a, GeometryVertex b,
+                                      GeometryVertex c, GeometryVertex d)
+{
+    v[0] = a;
+    v[1] = b;
+    v[2] = c;
+    v[3] = d;
+
+    return v + 4;
+}
@@ -0,0 +1,32 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+/*
+ * Rounded rectangle geometry as a list of quads. The corners are quarter
+ * circle fans built from unit offset tables computed once per segment count,
+ * the segment count is picked from the radius so the arc error stays under
+ * half a pixel. Every quad winds like the raylib rectangles (top left,
+ * bottom left, bottom right, top right on the screen), so they draw with the
+ * back face culling on. This module must not depend on raylib.
+ */
+
+#define GEOMETRY_MAX_SEGMENTS   16    // Segments of a quarter circle
+#define GEOMETRY_MAX_VERTICES   (3*4 + 4*4*((GEOMETRY_MAX_SEGMENTS + 1)/2))
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    float x;
+    float y;
+} GeometryVertex;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+int GetCornerSegments(float radius);
+const GeometryVertex * GetCornerTable(int segments);
+int BuildRoundedRectangle(float x, float y, float width, float height, float radius,
+                          GeometryVertex *vertices);
+
+#endif  // GEOMETRY_H
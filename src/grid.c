@@ -0,0 +1,284 @@
+#include "grid.h"
+
+/*
+ * Move and move check kernels of the NxN grid. With N a constant the line
+ * loops are unrolled and the cell offsets folded, one pair per grid size.
+ */
+#define DEFINE_GRID_KERNELS(N)                                                              \
+    static bool MoveGrid##N(unsigned char *cells, Direction direction, unsigned int *score) \
+    {                                                                                       \
+        bool moved = false;                                                                 \
+                                                                                            \
+        for (int line = 0; line < (N); line++)                                              \
+        {                                                                                   \
+            LineStart start = GetLineStart((N), direction, line);                           \
+                                                                                            \
+            moved |= SlideLine(cells, start.first, start.stride, (N), score);               \
+        }                                                                                   \
+        return moved;                                                                       \
+    }                                                                                       \
+                                                                                            \
+    static bool CanMoveGrid##N(const unsigned char *cells)                                  \
+    {                                                                                       \
+        for (int y = 0; y < (N); y++)                                                       \
+        {                                                                                   \
+            for (int x = 0; x < (N); x++)                                                   \
+            {                                                                               \
+                if (CanCellMove(cells, x, y, (N))) return true;                             \
+            }                                                                               \
+        }                                                                                   \
+        return false;                                                                       \
+    }
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    int first;     // Cell of the line next to the wall the tiles slide to
+    int stride;    // Offset to the next cell of the line
+} LineStart;
+
+typedef struct {
+    bool (*move)(unsigned char *cells, Direction direction, unsigned int *score);
+    bool (*canMove)(const unsigned char *cells);
+} GridKernels;
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static inline LineStart GetLineStart(int size, Direction direction, int line);
+static inline bool SlideLine(unsigned char *cells, int first, int stride, int length,
+                             unsigned int *score);
+static inline bool CanCellMove(const unsigned char *cells, int x, int y, int size);
+
+//-------------------------------------------------------------------------------------------------
+// Size-specialized Kernels Definition
+//-------------------------------------------------------------------------------------------------
+DEFINE_GRID_KERNELS(3)
+DEFINE_GRID_KERNELS(5)
+DEFINE_GRID_KERNELS(6)
+DEFINE_GRID_KERNELS(7)
+DEFINE_GRID_KERNELS(8)
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static const GridKernels kernels[GRID_MAX_SIZE + 1] = {
+    [3] = { MoveGrid3, CanMoveGrid3 },
+    // No 4x4 kernels, that grid runs the bitboard functions on its bitboard
+    [5] = { MoveGrid5, CanMoveGrid5 },
+    [6] = { MoveGrid6, CanMoveGrid6 },
+    [7] = { MoveGrid7, CanMoveGrid7 },
+    [8] = { MoveGrid8, CanMoveGrid8 },
+};
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Empty grid of the size, returns false if the size isn't supported
+bool InitGrid(Grid *grid, int size)
+{
+    if (size < GRID_MIN_SIZE || size > GRID_MAX_SIZE) return false;
+
+    InitMoveTables();    // The 4x4 grid moves with them
+
+    grid->size     = size;
+    grid->bitboard = 0;
+
+    for (int i = 0; i < GRID_MAX_CELLS; i++) grid->cells[i] = 0;
+
+    return true;
+}
+
+// Returns true if any tile moved
+bool MoveGrid(Grid *grid, Direction direction, unsigned int *score)
+{
+    *score = 0;
+
+    if (direction >= MOVE_COUNT) return false;
+
+    if (grid->size == BITBOARD_SIZE)
+    {
+        Bitboard moved = ExecuteMove(grid->bitboard, direction, score);
+
+        if (moved == grid->bitboard) return false;
+
+        grid->bitboard = moved;
+        return true;
+    }
+
+    return kernels[grid->size].move(grid->cells, direction, score);
+}
+
+void TraceGridMove(const Grid *grid, Direction direction, GridTrace *trace)
+{
+    for (int line = 0; line < grid->size; line++)
+    {
+        LineStart start = GetLineStart(grid->size, direction, line);
+        int last = -1;
+        unsigned int lastValue = 0;
+        bool lastMerged = false;
+
+        for (int k = 0; k < grid->size; k++)
+        {
+            int cell = start.first + k*start.stride;
+            unsigned int value = GetGridCell(grid, cell);
+
+            trace->target[cell] = cell;
+            trace->merged[cell] = 0;
+
+            if (!value) continue;
+
+            if (last >= 0 && value == lastValue && !lastMerged && value < GRID_MAX_VALUE)
+            {
+                trace->target[cell] = start.first + last*start.stride;
+                trace->merged[start.first + last*start.stride] = 1;
+                lastMerged = true;
+            }
+            else
+            {
+                trace->target[cell] = start.first + (++last)*start.stride;
+                lastValue  = value;
+                lastMerged = false;
+            }
+        }
+    }
+}
+
+bool CanMoveGrid(const Grid *grid)
+{
+    if (grid->size == BITBOARD_SIZE) return CanMove(grid->bitboard);
+
+    return kernels[grid->size].canMove(grid->cells);
+}
+
+/*
+ * Put a new tile into a random empty cell the same way SpawnTile() does.
+ * Returns the cell index or -1 if the grid is full.
+ */
+int SpawnGridTile(Grid *grid, RandomGenerator *random)
+{
+    if (grid->size == BITBOARD_SIZE) return SpawnTile(&grid->bitboard, random);
+
+    int empty = CountGridEmptyCells(grid);
+
+    if (!empty) return -1;
+
+    int nth = (int)NextRandomBelow(random, empty);
+
+    for (int i = 0; i < grid->size*grid->size; i++)
+    {
+        if (!grid->cells[i] && nth-- == 0)
+        {
+            grid->cells[i] = NextRandomBelow(random, 10) ? 1 : 2;
+            return i;
+        }
+    }
+    return -1;
+}
+
+int CountGridEmptyCells(const Grid *grid)
+{
+    int empty = 0;
+
+    if (grid->size == BITBOARD_SIZE) return CountEmptyCells(grid->bitboard);
+
+    for (int i = 0; i < grid->size*grid->size; i++) empty += !grid->cells[i];
+
+    return empty;
+}
+
+unsigned int GetGridMaxExponent(const Grid *grid)
+{
+    unsigned int max = 0;
+
+    if (grid->size == BITBOARD_SIZE) return GetMaxExponent(grid->bitboard);
+
+    for (int i = 0; i < grid->size*grid->size; i++)
+    {
+        if (grid->cells[i] > max) max = grid->cells[i];
+    }
+    return max;
+}
+
+// Only a 4x4 grid has a bitboard, the other sizes give an empty one
+Bitboard GridToBitboard(const Grid *grid)
+{
+    return (grid->size == BITBOARD_SIZE) ? grid->bitboard : 0;
+}
+
+void BitboardToGrid(Bitboard board, Grid *grid)
+{
+    InitGrid(grid, BITBOARD_SIZE);
+
+    grid->bitboard = board;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+static inline LineStart GetLineStart(int size, Direction direction, int line)
+{
+    switch (direction)
+    {
+    case MOVE_LEFT:  return (LineStart){ line*size, 1 };
+    case MOVE_RIGHT: return (LineStart){ line*size + size - 1, -1 };
+    case MOVE_UP:    return (LineStart){ line, size };
+    default:         return (LineStart){ (size - 1)*size + line, -size };
+    }
+}
+
+// Slide the line to its first cell merging the equal neighbours once, like SlideRow()
+static inline bool SlideLine(unsigned char *cells, int first, int stride, int length,
+                             unsigned int *score)
+{
+    unsigned char line[GRID_MAX_SIZE];
+    int count = 0;
+    bool merged = false;
+    bool moved = false;
+
+    for (int i = 0; i < length; i++)
+    {
+        unsigned char value = cells[first + i*stride];
+
+        if (!value) continue;
+
+        if (count > 0 && !merged && line[count - 1] == value && value < GRID_MAX_VALUE)
+        {
+            line[count - 1]++;
+            *score += 2u << value;    // Same as the value of the new tile
+            merged = true;
+        }
+        else
+        {
+            line[count++] = value;
+            merged = false;
+        }
+    }
+
+    for (int i = 0; i < length; i++)
+    {
+        unsigned char value = (i < count) ? line[i] : 0;
+
+        if (cells[first + i*stride] != value)
+        {
+            cells[first + i*stride] = value;
+            moved = true;
+        }
+    }
+
+    return moved;
+}
+
+// The cell is empty or merges with the neighbour on the right or below
+static inline bool CanCellMove(const unsigned char *cells, int x, int y, int size)
+{
+    unsigned char value = cells[y*size + x];
+
+    if (!value) return true;
+    if (value >= GRID_MAX_VALUE) return false;
+
+    return (x + 1 < size && cells[y*size + x + 1] == value) ||
+           (y + 1 < size && cells[(y + 1)*size + x] == value);
+}
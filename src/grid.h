@@ -0,0 +1,65 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdbool.h>
+#include "bitboard.h"
+#include "random.h"
+
+/*
+ * Game logic of the square grids from 3x3 to 8x8 chosen at runtime. Every
+ * cell is a byte holding the exponent like a bitboard nibble, cell (x, y) is
+ * the byte number y*size + x, the same index the 4x4 bitboard uses. The
+ * moves run on kernels generated for every size with the size as a compile
+ * time constant. A 4x4 grid is held in a bitboard instead of the bytes and
+ * runs the bitboard functions directly, read and write the cells through
+ * GetGridCell() and SetGridCell(). The spawns follow SpawnTile() exactly, so
+ * a 4x4 grid plays the same game as the bitboard from the same seed. This
+ * module must not depend on raylib.
+ */
+
+#define GRID_MIN_SIZE    3
+#define GRID_MAX_SIZE    8
+#define GRID_MAX_CELLS   (GRID_MAX_SIZE * GRID_MAX_SIZE)
+#define GRID_MAX_VALUE   BITBOARD_MAX_VALUE    // Two tiles of it don't merge, like on the bitboard
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    int size;                                // Cells per side
+    Bitboard bitboard;                       // Cells of a 4x4 grid, its bytes stay empty
+    unsigned char cells[GRID_MAX_CELLS];     // Exponents of the other sizes, 0 is an empty cell
+} Grid;
+
+// Per cell description of a move used to build the board animation
+typedef struct {
+    unsigned char target[GRID_MAX_CELLS];    // Cell index where the cell content ends up
+    unsigned char merged[GRID_MAX_CELLS];    // Set if a merge happened in the cell
+} GridTrace;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+bool InitGrid(Grid *grid, int size);
+bool MoveGrid(Grid *grid, Direction direction, unsigned int *score);
+void TraceGridMove(const Grid *grid, Direction direction, GridTrace *trace);
+bool CanMoveGrid(const Grid *grid);
+int SpawnGridTile(Grid *grid, RandomGenerator *random);
+int CountGridEmptyCells(const Grid *grid);
+unsigned int GetGridMaxExponent(const Grid *grid);
+
+Bitboard GridToBitboard(const Grid *grid);
+void BitboardToGrid(Bitboard board, Grid *grid);
+
+static inline unsigned int GetGridCell(const Grid *grid, int cell)
+{
+    return (grid->size == BITBOARD_SIZE) ? GetCell(grid->bitboard, cell) : grid->cells[cell];
+}
+
+static inline void SetGridCell(Grid *grid, int cell, unsigned int value)
+{
+    if (grid->size == BITBOARD_SIZE) grid->bitboard = SetCell(grid->bitboard, cell, value);
+    else grid->cells[cell] = (unsigned char)value;
+}
+
+#endif  // GRID_H
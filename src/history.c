@@ -0,0 +1,230 @@
+#include <stdio.h>      // fopen, fread, fwrite, fclose, snprintf, remove
+#include <stdlib.h>     // malloc, free
+#include <string.h>     // memcmp, memcpy
+#include <sys/param.h>  // PATH_MAX
+#include "byteorder.h"
+#include "checksum.h"
+#include "filesync.h"
+#include "history.h"
+
+#define HEADER_SIZE   14
+#define ENTRY_SIZE    12
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static const unsigned char magic[5] = { '2', '0', '4', '8', 'H' };
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static inline unsigned int GetIndex(const History *history, unsigned int position);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+bool InitHistory(History *history, unsigned int capacity)
+{
+    history->cells    = malloc(sizeof(Bitboard) * capacity);
+    history->scores   = malloc(sizeof(uint32_t) * capacity);
+    history->capacity = capacity;
+    history->head     = 0;
+    history->count    = 0;
+    history->cursor   = 0;
+
+    if (!history->cells || !history->scores)
+    {
+        UnloadHistory(history);
+        return false;
+    }
+
+    return true;
+}
+
+void UnloadHistory(History *history)
+{
+    free(history->cells);
+    free(history->scores);
+
+    history->cells    = NULL;
+    history->scores   = NULL;
+    history->capacity = 0;
+    history->count    = 0;
+}
+
+// Start over from the single position
+void ResetHistory(History *history, Bitboard cells)
+{
+    if (!history->capacity) return;
+
+    history->head      = 0;
+    history->count     = 1;
+    history->cursor    = 0;
+    history->cells[0]  = cells;
+    history->scores[0] = 0;
+}
+
+void PushHistory(History *history, Bitboard cells, uint32_t score)
+{
+    if (!history->capacity) return;
+
+    if (history->count == 0)
+    {
+        score = 0;    // The first position has no move leading to it
+    }
+    else
+    {
+        history->count = history->cursor + 1;    // Drop the positions that could be redone
+    }
+
+    if (history->count == history->capacity)
+    {
+        history->head = GetIndex(history, 1);
+        history->count--;
+    }
+
+    unsigned int index = GetIndex(history, history->count);
+
+    history->cells[index]  = cells;
+    history->scores[index] = score;
+    history->cursor        = history->count++;
+}
+
+// Step back to the previous position, the score receives the points to take back
+bool UndoHistory(History *history, Bitboard *cells, uint32_t *score)
+{
+    if (history->count == 0 || history->cursor == 0) return false;
+
+    *score = history->scores[GetIndex(history, history->cursor)];
+    *cells = history->cells[GetIndex(history, --history->cursor)];
+
+    return true;
+}
+
+// Step forward to the next position, the score receives the points to give back
+bool RedoHistory(History *history, Bitboard *cells, uint32_t *score)
+{
+    if (history->cursor + 1 >= history->count) return false;
+
+    unsigned int index = GetIndex(history, ++history->cursor);
+
+    *score = history->scores[index];
+    *cells = history->cells[index];
+
+    return true;
+}
+
+/*
+ * Write the history to a temporary file, sync it and rename it over the old
+ * one, a crash while saving leaves the previous history intact.
+ */
+int SaveHistory(const History *history, const char *path)
+{
+    unsigned char data[HEADER_SIZE > ENTRY_SIZE ? HEADER_SIZE : ENTRY_SIZE];
+    char temp[PATH_MAX];
+
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+
+    FILE *file = fopen(temp, "wb");
+
+    if (!file) return -1;
+
+    memcpy(data, magic, sizeof(magic));
+    data[5] = HISTORY_VERSION;
+    PutU32(data + 6, history->count);
+    PutU32(data + 10, history->cursor);
+
+    uint32_t crc = UpdateCrc32(0, data, HEADER_SIZE);
+    bool failed = fwrite(data, HEADER_SIZE, 1, file) != 1;
+
+    for (unsigned int i = 0; i < history->count && !failed; i++)
+    {
+        unsigned int index = GetIndex(history, i);
+
+        PutU64(data, history->cells[index]);
+        PutU32(data + 8, history->scores[index]);
+
+        crc = UpdateCrc32(crc, data, ENTRY_SIZE);
+        failed = fwrite(data, ENTRY_SIZE, 1, file) != 1;
+    }
+
+    PutU32(data, crc);
+    if (!failed) failed = fwrite(data, 4, 1, file) != 1;
+    if (!failed) failed = SyncFile(file) != 0;
+
+    if (fclose(file) != 0) failed = true;
+    if (!failed) failed = MoveFileOver(temp, path) != 0;
+
+    if (failed) remove(temp);
+
+    return failed ? -1 : 0;
+}
+
+/*
+ * Load the history only if it is intact and its current position is the
+ * board the game was restored with. On failure the content is undefined and
+ * the history must be reset.
+ */
+int LoadHistory(History *history, const char *path, Bitboard current)
+{
+    unsigned char data[HEADER_SIZE];
+    FILE *file = fopen(path, "rb");
+    int result = -1;
+
+    if (!history->capacity || !file)
+    {
+        if (file) fclose(file);
+        return -1;
+    }
+
+    if (fread(data, HEADER_SIZE, 1, file) == 1 && memcmp(data, magic, sizeof(magic)) == 0 &&
+        data[5] == HISTORY_VERSION)
+    {
+        unsigned int count  = GetU32(data + 6);
+        unsigned int cursor = GetU32(data + 10);
+        uint32_t crc = UpdateCrc32(0, data, HEADER_SIZE);
+        unsigned int skip = (count > history->capacity) ? count - history->capacity : 0;
+
+        // The oldest positions are dropped if the capacity got smaller
+        if (count > 0 && cursor < count && cursor >= skip)
+        {
+            History loaded = *history;
+            bool valid = true;
+
+            loaded.head   = 0;
+            loaded.count  = count - skip;
+            loaded.cursor = cursor - skip;
+
+            for (unsigned int i = 0; i < count && valid; i++)
+            {
+                valid = fread(data, ENTRY_SIZE, 1, file) == 1;
+                crc = UpdateCrc32(crc, data, ENTRY_SIZE);
+
+                if (valid && i >= skip)
+                {
+                    loaded.cells[i - skip]  = GetU64(data);
+                    loaded.scores[i - skip] = GetU32(data + 8);
+                }
+            }
+
+            if (valid && fread(data, 4, 1, file) == 1 && GetU32(data) == crc &&
+                loaded.cells[loaded.cursor] == current)
+            {
+                *history = loaded;
+                result = 0;
+            }
+        }
+    }
+
+    fclose(file);
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+static inline unsigned int GetIndex(const History *history, unsigned int position)
+{
+    return (history->head + position) % history->capacity;
+}
@@ -0,0 +1,51 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bitboard.h"
+
+/*
+ * Undo/redo history of the board positions. Every position is a packed
+ * 8-byte board plus the score gained by the move leading to it, kept in ring
+ * buffers allocated once, so a move never allocates and undo/redo are O(1).
+ * When the buffers are full the oldest position is dropped. A new move after
+ * an undo drops the positions that could be redone.
+ * This module must not depend on raylib.
+ *
+ * The file is rewritten to a temporary file and renamed over the old one.
+ *
+ * File format (all numbers little-endian):
+ *   "2048H" magic, version byte, count u32, cursor u32,
+ *   count x (cells u64, score u32), CRC-32 of everything before it u32
+ */
+
+#define HISTORY_CAPACITY   65536    // Positions, 768 KB
+#define HISTORY_VERSION    1
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    Bitboard *cells;               // Positions from the oldest one at head
+    uint32_t *scores;              // Score gained by the move leading to the position
+    unsigned int capacity;
+    unsigned int head;
+    unsigned int count;            // Positions stored
+    unsigned int cursor;           // Current position, the ones after it can be redone
+} History;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+bool InitHistory(History *history, unsigned int capacity);
+void UnloadHistory(History *history);
+void ResetHistory(History *history, Bitboard cells);
+void PushHistory(History *history, Bitboard cells, uint32_t score);
+bool UndoHistory(History *history, Bitboard *cells, uint32_t *score);
+bool RedoHistory(History *history, Bitboard *cells, uint32_t *score);
+
+int SaveHistory(const History *history, const char *path);
+int LoadHistory(History *history, const char *path, Bitboard current);
+
+#endif  // HISTORY_H
@@ -0,0 +1,289 @@
+#include <stdlib.h>  // malloc, calloc, free
+#include "hugegrid.h"
+
+#define CHUNKS_PER_WORKER   4     // Smaller chunks even out the lines with more work
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+struct HugeGridChunk {
+    HugeGrid *grid;
+    Direction direction;
+    int firstLine;                 // Lines of the chunk, the last one excluded
+    int lastLine;
+    uint64_t score;
+    unsigned int max;              // Highest exponent merged in the chunk
+    bool moved;
+};
+
+typedef struct {
+    long first;                    // Cell of the line next to the wall the tiles slide to
+    long stride;                   // Offset to the next cell of the line
+} HugeLineStart;
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static void RunChunks(HugeGrid *grid, Direction direction, TaskFunction function);
+static void SlideChunk(void *arg, int worker);
+static void CollectChunkFreeCells(void *arg, int worker);
+static inline HugeLineStart GetHugeLineStart(int size, Direction direction, int line);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Empty grid of the size, the pool may be NULL or shared with other work
+bool InitHugeGrid(HugeGrid *grid, int size, ThreadPool *pool)
+{
+    *grid = (HugeGrid){ 0 };
+
+    if (size < HUGE_GRID_MIN_SIZE || size > HUGE_GRID_MAX_SIZE) return false;
+
+    long cells = (long)size * size;
+
+    grid->size        = size;
+    grid->pool        = pool;
+    grid->chunkCount  = pool ? pool->count * CHUNKS_PER_WORKER : 1;
+    grid->cells       = calloc(cells, 1);
+    grid->freeCells   = malloc(sizeof(uint32_t) * cells);
+    grid->lineOffsets = malloc(sizeof(uint32_t) * (size + 1));
+
+    if (grid->chunkCount > size) grid->chunkCount = size;
+
+    grid->chunks = calloc(grid->chunkCount, sizeof(HugeGridChunk));
+
+    if (!grid->cells || !grid->freeCells || !grid->lineOffsets || !grid->chunks)
+    {
+        UnloadHugeGrid(grid);
+        return false;
+    }
+
+    for (long i = 0; i < cells; i++) grid->freeCells[i] = (uint32_t)i;
+
+    grid->freeCount = (uint32_t)cells;
+
+    return true;
+}
+
+void UnloadHugeGrid(HugeGrid *grid)
+{
+    free(grid->cells);
+    free(grid->freeCells);
+    free(grid->lineOffsets);
+    free(grid->chunks);
+
+    *grid = (HugeGrid){ 0 };
+}
+
+/*
+ * Slide every line in place and rebuild the free list from the lines, two
+ * passes over the chunks with the offsets of the line empty cells summed up
+ * in between. Returns true if any tile moved.
+ */
+bool MoveHugeGrid(HugeGrid *grid, Direction direction, uint64_t *score)
+{
+    bool moved = false;
+
+    *score = 0;
+
+    if (direction >= MOVE_COUNT) return false;
+
+    RunChunks(grid, direction, SlideChunk);
+
+    for (int i = 0; i < grid->chunkCount; i++)
+    {
+        HugeGridChunk *chunk = &grid->chunks[i];
+
+        *score += chunk->score;
+        moved  |= chunk->moved;
+
+        if (chunk->max > grid->max) grid->max = chunk->max;
+    }
+
+    if (!moved) return false;
+
+    // The slide left the number of empty cells of the line l in the entry l + 1
+    grid->lineOffsets[0] = 0;
+
+    for (int line = 0; line < grid->size; line++)
+    {
+        grid->lineOffsets[line + 1] += grid->lineOffsets[line];
+    }
+
+    grid->freeCount = grid->lineOffsets[grid->size];
+
+    RunChunks(grid, direction, CollectChunkFreeCells);
+
+    return true;
+}
+
+/*
+ * Put a new tile into a random empty cell, a 2 with 90% probability and a 4
+ * with 10% probability. Returns the cell index or -1 if the grid is full.
+ */
+long SpawnHugeGridTile(HugeGrid *grid, RandomGenerator *random)
+{
+    if (!grid->freeCount) return -1;
+
+    uint32_t nth  = NextRandomBelow(random, grid->freeCount);
+    uint32_t cell = grid->freeCells[nth];
+
+    // Move the last entry into the hole, the order of the list doesn't matter
+    grid->freeCells[nth] = grid->freeCells[--grid->freeCount];
+    grid->cells[cell]    = NextRandomBelow(random, 10) ? 1 : 2;
+
+    if (grid->cells[cell] > grid->max) grid->max = grid->cells[cell];
+
+    return cell;
+}
+
+/*
+ * Change the value of a tile already on the grid and keep the highest
+ * exponent up to date. The free list isn't touched, so the cell must hold a
+ * tile and the value must not be 0.
+ */
+void SetHugeGridTile(HugeGrid *grid, long cell, unsigned int value)
+{
+    grid->cells[cell] = (unsigned char)value;
+
+    if (value > grid->max) grid->max = value;
+}
+
+// A grid with an empty cell can always move, only a full one is scanned
+bool CanMoveHugeGrid(const HugeGrid *grid)
+{
+    int size = grid->size;
+
+    if (grid->freeCount) return true;
+
+    for (int y = 0; y < size; y++)
+    {
+        const unsigned char *row = &grid->cells[(long)y * size];
+
+        for (int x = 0; x < size; x++)
+        {
+            if (row[x] >= HUGE_GRID_MAX_VALUE) continue;
+
+            if (x + 1 < size && row[x] == row[x + 1]) return true;
+            if (y + 1 < size && row[x] == row[x + size]) return true;
+        }
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Split the lines among the chunks and run them, on the pool if the grid is big enough
+static void RunChunks(HugeGrid *grid, Direction direction, TaskFunction function)
+{
+    bool parallel = grid->pool && grid->size >= HUGE_GRID_PARALLEL_SIZE;
+
+    for (int i = 0; i < grid->chunkCount; i++)
+    {
+        HugeGridChunk *chunk = &grid->chunks[i];
+
+        chunk->grid      = grid;
+        chunk->direction = direction;
+        chunk->firstLine = (int)((long)grid->size * i / grid->chunkCount);
+        chunk->lastLine  = (int)((long)grid->size * (i + 1) / grid->chunkCount);
+
+        if (parallel) SubmitTask(grid->pool, i, function, chunk);
+        else function(chunk, 0);
+    }
+
+    if (parallel) WaitThreadPool(grid->pool);
+}
+
+// Slide the lines of the chunk, the tiles are compacted in place like SlideRow() does it
+static void SlideChunk(void *arg, int worker)
+{
+    HugeGridChunk *chunk = arg;
+    HugeGrid *grid = chunk->grid;
+    unsigned char *cells = grid->cells;
+
+    (void)worker;
+
+    chunk->score = 0;
+    chunk->max   = 0;
+    chunk->moved = false;
+
+    for (int line = chunk->firstLine; line < chunk->lastLine; line++)
+    {
+        HugeLineStart start = GetHugeLineStart(grid->size, chunk->direction, line);
+        unsigned char *last = NULL;    // Last tile placed, NULL until there is one
+        bool merged = false;
+        int count = 0;
+
+        for (int i = 0; i < grid->size; i++)
+        {
+            unsigned char *cell = &cells[start.first + i*start.stride];
+            unsigned char value = *cell;
+
+            if (!value) continue;
+
+            if (last && !merged && *last == value && value < HUGE_GRID_MAX_VALUE)
+            {
+                (*last)++;
+                *cell = 0;
+
+                chunk->score += 2ull << value;    // Same as the value of the new tile
+                chunk->moved  = true;
+                merged = true;
+
+                if (*last > chunk->max) chunk->max = *last;
+            }
+            else
+            {
+                last = &cells[start.first + count*start.stride];
+
+                // The cells before this one were read already, the write can't lose a tile
+                if (last != cell)
+                {
+                    *last = value;
+                    *cell = 0;
+                    chunk->moved = true;
+                }
+
+                count++;
+                merged = false;
+            }
+        }
+
+        grid->lineOffsets[line + 1] = grid->size - count;
+    }
+}
+
+// The empty cells of a slid line are the ones after its tiles
+static void CollectChunkFreeCells(void *arg, int worker)
+{
+    HugeGridChunk *chunk = arg;
+    HugeGrid *grid = chunk->grid;
+
+    (void)worker;
+
+    for (int line = chunk->firstLine; line < chunk->lastLine; line++)
+    {
+        HugeLineStart start = GetHugeLineStart(grid->size, chunk->direction, line);
+        uint32_t *entry = &grid->freeCells[grid->lineOffsets[line]];
+        int empty = grid->lineOffsets[line + 1] - grid->lineOffsets[line];
+
+        for (int i = grid->size - empty; i < grid->size; i++)
+        {
+            *entry++ = (uint32_t)(start.first + i*start.stride);
+        }
+    }
+}
+
+static inline HugeLineStart GetHugeLineStart(int size, Direction direction, int line)
+{
+    switch (direction)
+    {
+    case MOVE_LEFT:  return (HugeLineStart){ (long)line*size, 1 };
+    case MOVE_RIGHT: return (HugeLineStart){ (long)line*size + size - 1, -1 };
+    case MOVE_UP:    return (HugeLineStart){ line, size };
+    default:         return (HugeLineStart){ (long)(size - 1)*size + line, -size };
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef HUGEGRID_H
+#define HUGEGRID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bitboard.h"
+#include "random.h"
+#include "threadpool.h"
+
+/*
+ * Experimental game logic of the very large grids, up to 1024x1024. The rows
+ * are stored one after another as a byte exponent per cell. A move slides
+ * the lines (the rows or the columns) in place; the lines are independent,
+ * so big grids split them into chunks run on the thread pool. The empty cells
+ * are kept in a free list rebuilt by the same chunks, a spawn takes a random
+ * entry of it in O(1). The exponents go up to 63 and the score is 64-bit,
+ * past the 2^15 tile of the bitboard and the 32-bit tile values.
+ * This module must not depend on raylib.
+ */
+
+#define HUGE_GRID_MIN_SIZE        2
+#define HUGE_GRID_MAX_SIZE        1024
+#define HUGE_GRID_MAX_VALUE       63      // Two tiles of it don't merge, 2^63 fits the score
+#define HUGE_GRID_PARALLEL_SIZE   64      // Smaller grids move on the calling thread
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct HugeGridChunk HugeGridChunk;
+
+typedef struct {
+    int size;                      // Cells per side
+    unsigned char *cells;          // Exponents row after row, 0 is an empty cell
+    uint32_t *freeCells;           // Indices of the empty cells in no particular order
+    uint32_t freeCount;
+    unsigned int max;              // Highest exponent on the grid
+    uint32_t *lineOffsets;         // Start of the empty cells of every line in the free list
+    ThreadPool *pool;              // NULL moves every line on the calling thread
+    HugeGridChunk *chunks;
+    int chunkCount;
+} HugeGrid;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+bool InitHugeGrid(HugeGrid *grid, int size, ThreadPool *pool);
+void UnloadHugeGrid(HugeGrid *grid);
+bool MoveHugeGrid(HugeGrid *grid, Direction direction, uint64_t *score);
+long SpawnHugeGridTile(HugeGrid *grid, RandomGenerator *random);
+void SetHugeGridTile(HugeGrid *grid, long cell, unsigned int value);
+bool CanMoveHugeGrid(const HugeGrid *grid);
+
+#endif  // HUGEGRID_H
@@ -0,0 +1,149 @@
+#include <stdio.h>   // fopen, fgets, sscanf, fclose
+#include <stdlib.h>  // realloc, free
+#include <string.h>  // strcmp
+#include "input.h"
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static const char *moveNames[MOVE_COUNT] = { "left", "right", "up", "down" };
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Returns false and counts the move as dropped if the queue is full
+bool PushInput(InputQueue *queue, Direction move, double time)
+{
+    queue->stats.received++;
+
+    if (queue->count == INPUT_QUEUE_CAPACITY)
+    {
+        queue->stats.dropped++;
+        return false;
+    }
+
+    unsigned int tail = (queue->head + queue->count) % INPUT_QUEUE_CAPACITY;
+
+    queue->events[tail] = (InputEvent){ move, time };
+    queue->count++;
+
+    return true;
+}
+
+bool PopInput(InputQueue *queue, InputEvent *event)
+{
+    if (queue->count == 0) return false;
+
+    *event = queue->events[queue->head];
+
+    queue->head = (queue->head + 1) % INPUT_QUEUE_CAPACITY;
+    queue->count--;
+
+    return true;
+}
+
+// Drop the waiting moves, they count as dropped
+void ClearInput(InputQueue *queue)
+{
+    queue->stats.dropped += queue->count;
+
+    queue->head  = 0;
+    queue->count = 0;
+}
+
+void RecordInputApplied(InputQueue *queue, const InputEvent *event, double time)
+{
+    double latency = time - event->time;
+
+    queue->stats.applied++;
+    queue->stats.totalLatency += latency;
+
+    if (latency > queue->stats.maxLatency) queue->stats.maxLatency = latency;
+}
+
+// Returns 0 on success, -1 if the file can't be read or a line is malformed
+int LoadInputScript(InputScript *script, const char *path)
+{
+    char line[128];
+    unsigned int capacity = 0;
+    FILE *file = fopen(path, "r");
+
+    *script = (InputScript){ 0 };
+
+    if (!file) return -1;
+
+    while (fgets(line, sizeof(line), file))
+    {
+        char name[16];
+        double time;
+        int move;
+
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+
+        if (sscanf(line, "%lf %15s", &time, name) != 2) break;
+
+        for (move = 0; move < MOVE_COUNT; move++)
+        {
+            if (strcmp(name, moveNames[move]) == 0) break;
+        }
+
+        if (move == MOVE_COUNT) break;
+
+        if (script->count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+
+            InputEvent *events = realloc(script->events, sizeof(InputEvent) * capacity);
+
+            if (!events) break;
+
+            script->events = events;
+        }
+
+        script->events[script->count++] = (InputEvent){ move, time };
+    }
+
+    // Stopped before the end of the file on an error
+    bool complete = feof(file);
+
+    fclose(file);
+
+    if (!complete)
+    {
+        UnloadInputScript(script);
+        return -1;
+    }
+
+    return 0;
+}
+
+void UnloadInputScript(InputScript *script)
+{
+    free(script->events);
+
+    *script = (InputScript){ 0 };
+}
+
+/*
+ * Push the moves of the script that are due at the time, stamped with the
+ * time they were due, so the latency includes the wait for the frame.
+ * Returns the number of moves pushed.
+ */
+unsigned int FeedInputScript(InputScript *script, InputQueue *queue, double time)
+{
+    unsigned int fed = 0;
+
+    if (script->start == 0) script->start = time;
+
+    while (script->next < script->count &&
+           script->start + script->events[script->next].time <= time)
+    {
+        const InputEvent *event = &script->events[script->next++];
+
+        PushInput(queue, event->move, script->start + event->time);
+        fed++;
+    }
+
+    return fed;
+}
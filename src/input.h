@@ -0,0 +1,62 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include "bitboard.h"
+
+/*
+ * Bounded queue of the entered moves. Every move is stamped with the time it
+ * was entered, so the time until it reaches the logical board and the moves
+ * lost to a full queue are measured. An input script feeds the queue with
+ * synthetic moves at fixed times to measure the same without a player.
+ * This module must not depend on raylib.
+ *
+ * Script format, a move per line, the lines starting with '#' are skipped:
+ *   <seconds from the start> <left|right|up|down>
+ */
+
+#define INPUT_QUEUE_CAPACITY   16    // Moves, more than a frame ever gets
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    Direction move;
+    double time;                   // GetMonotonicTime() the move was entered at
+} InputEvent;
+
+typedef struct {
+    unsigned long long received;   // Moves pushed, the dropped ones included
+    unsigned long long applied;
+    unsigned long long dropped;    // Moves lost to a full or cleared queue
+    double totalLatency;           // Seconds from entering to applying the moves
+    double maxLatency;
+} InputStats;
+
+typedef struct {
+    InputEvent events[INPUT_QUEUE_CAPACITY];
+    unsigned int head;
+    unsigned int count;
+    InputStats stats;
+} InputQueue;
+
+typedef struct {
+    InputEvent *events;            // Times from the start of the script
+    unsigned int count;
+    unsigned int next;             // First move not fed yet
+    double start;                  // Time of the first feed, 0 before it
+} InputScript;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+bool PushInput(InputQueue *queue, Direction move, double time);
+bool PopInput(InputQueue *queue, InputEvent *event);
+void ClearInput(InputQueue *queue);
+void RecordInputApplied(InputQueue *queue, const InputEvent *event, double time);
+
+int LoadInputScript(InputScript *script, const char *path);
+void UnloadInputScript(InputScript *script);
+unsigned int FeedInputScript(InputScript *script, InputQueue *queue, double time);
+
+#endif  // INPUT_H
@@ -0,0 +1,447 @@
+#include <string.h>     // memcmp
+#include "byteorder.h"
+#include "checksum.h"
+#include "filesync.h"
+#include "journal.h"
+#include "timer.h"
+
+#define HEADER_SIZE     13
+#define LEGACY_HEADER   5       // Version 1 and 2 header, magic and version only
+#define SNAPSHOT_TAG    0x80
+#define SNAPSHOT_SIZE   65      // Snapshot record fields without the tag and the checksum
+#define CHECKSUM_SIZE   4
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static const unsigned char magic[4] = { '2', '0', '4', '8' };
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static int ReadHeader(FILE *stream, uint32_t *sequence);
+static int WriteHeader(FILE *stream, uint32_t sequence);
+static int WriteSnapshot(FILE *stream, const JournalSnapshot *snapshot);
+static bool ReadSnapshot(FILE *stream, int version, JournalSnapshot *snapshot);
+static void DecodeSnapshot(const unsigned char *data, JournalSnapshot *snapshot);
+static bool ValidateSnapshot(const JournalSnapshot *snapshot);
+static bool ReplayMove(JournalSnapshot *state, unsigned char record);
+static int FinishWrite(Journal *journal);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+int OpenJournal(Journal *journal, const char *path, unsigned int interval)
+{
+    journal->path     = path;
+    journal->sequence = 0;
+    journal->interval = interval ? interval : JOURNAL_SNAPSHOT_INTERVAL;
+    journal->pending  = 0;
+    journal->sync     = (SyncPolicy){ SYNC_EVERY_MOVE, 0, 0.0 };
+    journal->unsynced = 0;
+    journal->synced   = GetMonotonicTime();
+    journal->written  = 0;
+    journal->syncs    = 0;
+
+    snprintf(journal->temp, sizeof(journal->temp), "%s.tmp", path);
+
+    if ((journal->file = fopen(path, "rb+")) == NULL)
+    {
+        journal->file = fopen(path, "wb+");
+    }
+
+    return journal->file ? 0 : -1;
+}
+
+// Sync the writes the policy has left pending and close the file
+void CloseJournal(Journal *journal)
+{
+    if (!journal->file) return;
+
+    if (journal->unsynced && journal->sync.mode != SYNC_NEVER) SyncFile(journal->file);
+
+    fclose(journal->file);
+    journal->file = NULL;
+}
+
+void SetJournalSyncPolicy(Journal *journal, SyncPolicy policy)
+{
+    journal->sync = policy;
+}
+
+/*
+ * Keep an unrecoverable journal next to the new one instead of overwriting
+ * it. Returns 1 if the journal was moved away, 0 if it was empty.
+ */
+int BackupJournal(Journal *journal)
+{
+    char backup[PATH_MAX];
+
+    if (!journal->file) return -1;
+
+    fseek(journal->file, 0, SEEK_END);
+    if (ftell(journal->file) <= 0) return 0;
+
+    snprintf(backup, sizeof(backup), "%s.bak", journal->path);
+
+    fclose(journal->file);
+    int moved = MoveFileOver(journal->path, backup);
+    journal->file = fopen(journal->path, moved == 0 ? "wb+" : "rb+");
+
+    return (moved == 0 && journal->file) ? 1 : -1;
+}
+
+/*
+ * Replace the journal with a new one starting from the snapshot. The new
+ * journal is written and synced to the temporary file first and renamed over
+ * the old one, the rename is atomic so a crash never leaves a torn journal.
+ */
+int StartJournal(Journal *journal, const JournalSnapshot *snapshot)
+{
+    FILE *temp = fopen(journal->temp, "wb");
+
+    if (!temp) return -1;
+
+    int header = WriteHeader(temp, journal->sequence + 1);
+    int size = WriteSnapshot(temp, snapshot);
+    int synced = (journal->sync.mode == SYNC_NEVER) ? fflush(temp) : SyncFile(temp);
+
+    if (fclose(temp) != 0 || header < 0 || size < 0 || synced != 0)
+    {
+        remove(journal->temp);
+        return -1;
+    }
+
+    if (journal->file) fclose(journal->file);
+
+    int moved = MoveFileOver(journal->temp, journal->path);
+
+    if ((journal->file = fopen(journal->path, "rb+")) == NULL || moved != 0) return -1;
+
+    fseek(journal->file, 0, SEEK_END);
+
+    journal->sequence++;
+    journal->pending  = 0;
+    journal->unsynced = 0;
+    journal->synced   = GetMonotonicTime();
+    journal->written += header + size;
+
+    if (journal->sync.mode != SYNC_NEVER) journal->syncs++;
+
+    return 0;
+}
+
+/*
+ * Append a single move record. The state after the move is only written
+ * when the snapshot interval is reached.
+ */
+int AppendJournalMove(Journal *journal, JournalMove move, const JournalSnapshot *state)
+{
+    if (!journal->file) return -1;
+
+    unsigned char record = (move.direction & 0x3) | ((move.cell & 0xF) << 2) |
+                           ((move.value == 2) << 6);
+
+    if (fputc(record, journal->file) == EOF) return -1;
+
+    journal->written++;
+
+    if (++journal->pending >= journal->interval)
+    {
+        int size = WriteSnapshot(journal->file, state);
+
+        if (size < 0) return -1;
+
+        journal->pending  = 0;
+        journal->written += size;
+    }
+
+    return FinishWrite(journal);
+}
+
+int AppendJournalSnapshot(Journal *journal, const JournalSnapshot *snapshot)
+{
+    if (!journal->file) return -1;
+
+    int size = WriteSnapshot(journal->file, snapshot);
+
+    if (size < 0) return -1;
+
+    journal->pending  = 0;
+    journal->written += size;
+
+    return FinishWrite(journal);
+}
+
+/*
+ * Restore the state from the journal file and position it for appending.
+ * A new journal left in the temporary file by a crash before the rename wins
+ * if it is valid and newer. A journal with an invalid tail or an older
+ * version is compacted to the recovered state. Returns the number of replayed
+ * moves or -1 if there is nothing to recover.
+ */
+int RecoverJournal(Journal *journal, JournalSnapshot *snapshot)
+{
+    uint32_t sequence = 0;
+    long end = 0;
+
+    if (!journal->file) return -1;
+
+    int replayed = ReplayJournal(journal->file, snapshot, &end);
+    int version = ReadHeader(journal->file, &sequence);
+    bool rewrite = (version != JOURNAL_VERSION);
+
+    FILE *temp = fopen(journal->temp, "rb");
+
+    if (temp)
+    {
+        JournalSnapshot state;
+        uint32_t tempSequence = 0;
+        long tempEnd = 0;
+        int tempReplayed = ReplayJournal(temp, &state, &tempEnd);
+
+        ReadHeader(temp, &tempSequence);
+        fclose(temp);
+        remove(journal->temp);
+
+        if (tempReplayed >= 0 && (replayed < 0 || tempSequence > sequence))
+        {
+            *snapshot = state;
+            replayed  = tempReplayed;
+            sequence  = tempSequence;
+            rewrite   = true;
+        }
+    }
+
+    if (replayed < 0) return -1;
+
+    journal->sequence = sequence;
+
+    fseek(journal->file, 0, SEEK_END);
+
+    if (rewrite || ftell(journal->file) != end)
+    {
+        if (StartJournal(journal, snapshot) != 0) return -1;
+    }
+    else
+    {
+        journal->pending = replayed;
+    }
+
+    return replayed;
+}
+
+// Write the header and the snapshot to the beginning of the stream, returns the written size
+int WriteJournal(FILE *stream, const JournalSnapshot *snapshot)
+{
+    fseek(stream, 0, SEEK_SET);
+
+    int header = WriteHeader(stream, 0);
+    int size = WriteSnapshot(stream, snapshot);
+
+    return (header < 0 || size < 0) ? -1 : header + size;
+}
+
+/*
+ * Read the stream from the beginning and replay it to the last valid record,
+ * the end receives the offset right after it. Returns the number of moves
+ * replayed after the last snapshot or -1 if no snapshot was found.
+ */
+int ReplayJournal(FILE *stream, JournalSnapshot *snapshot, long *end)
+{
+    JournalSnapshot state = { 0 };
+    uint32_t sequence;
+    int version = ReadHeader(stream, &sequence);
+    int replayed = -1;
+    int record;
+
+    if (version < 0) return -1;
+
+    while ((record = fgetc(stream)) != EOF)
+    {
+        if (record & SNAPSHOT_TAG)
+        {
+            if (record != SNAPSHOT_TAG || !ReadSnapshot(stream, version, &state)) break;
+
+            replayed = 0;
+        }
+        else
+        {
+            if (replayed < 0 || !ReplayMove(&state, record)) break;
+            replayed++;
+        }
+
+        *snapshot = state;
+        *end = ftell(stream);
+    }
+
+    return replayed;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+/*
+ * Read the header at the beginning of the stream and leave the stream right
+ * after it. Returns the version or -1 if it isn't a valid journal.
+ */
+static int ReadHeader(FILE *stream, uint32_t *sequence)
+{
+    unsigned char data[HEADER_SIZE];
+
+    fseek(stream, 0, SEEK_SET);
+    *sequence = 0;
+
+    if (fread(data, LEGACY_HEADER, 1, stream) != 1 || memcmp(data, magic, 4) != 0) return -1;
+
+    int version = data[4];
+
+    if (version < 1 || version > JOURNAL_VERSION) return -1;
+    if (version < 3) return version;
+
+    if (fread(data + LEGACY_HEADER, HEADER_SIZE - LEGACY_HEADER, 1, stream) != 1) return -1;
+    if (GetU32(data + 9) != UpdateCrc32(0, data, 9)) return -1;
+
+    *sequence = GetU32(data + 5);
+
+    return version;
+}
+
+static int WriteHeader(FILE *stream, uint32_t sequence)
+{
+    unsigned char data[HEADER_SIZE] = { magic[0], magic[1], magic[2], magic[3], JOURNAL_VERSION };
+
+    PutU32(data + 5, sequence);
+    PutU32(data + 9, UpdateCrc32(0, data, 9));
+
+    return (fwrite(data, HEADER_SIZE, 1, stream) == 1) ? HEADER_SIZE : -1;
+}
+
+static int WriteSnapshot(FILE *stream, const JournalSnapshot *snapshot)
+{
+    unsigned char data[1 + SNAPSHOT_SIZE + CHECKSUM_SIZE];
+
+    data[0] = SNAPSHOT_TAG;
+    PutU64(data + 1, snapshot->cells);
+    PutU64(data + 9, snapshot->seed);
+
+    for (int i = 0; i < 4; i++)
+    {
+        PutU64(data + 17 + 8*i, snapshot->random.state[i]);
+    }
+
+    PutU32(data + 49, snapshot->score);
+    PutU32(data + 53, snapshot->best);
+    PutU32(data + 57, snapshot->moves);
+    PutU32(data + 61, snapshot->max);
+    data[65] = snapshot->win;
+    PutU32(data + 66, UpdateCrc32(0, data, 1 + SNAPSHOT_SIZE));
+
+    return (fwrite(data, sizeof(data), 1, stream) == 1) ? (int)sizeof(data) : -1;
+}
+
+// Read the snapshot fields following the tag, the snapshot is left untouched if they are invalid
+static bool ReadSnapshot(FILE *stream, int version, JournalSnapshot *snapshot)
+{
+    unsigned char data[1 + SNAPSHOT_SIZE + CHECKSUM_SIZE] = { SNAPSHOT_TAG };
+    int size = SNAPSHOT_SIZE + ((version >= 2) ? CHECKSUM_SIZE : 0);
+    JournalSnapshot state;
+
+    if (fread(data + 1, size, 1, stream) != 1) return false;
+
+    if (version >= 2 &&
+        GetU32(data + 1 + SNAPSHOT_SIZE) != UpdateCrc32(0, data, 1 + SNAPSHOT_SIZE))
+    {
+        return false;
+    }
+
+    DecodeSnapshot(data + 1, &state);
+
+    if (!ValidateSnapshot(&state)) return false;
+
+    *snapshot = state;
+    return true;
+}
+
+static void DecodeSnapshot(const unsigned char *data, JournalSnapshot *snapshot)
+{
+    snapshot->cells = GetU64(data);
+    snapshot->seed  = GetU64(data + 8);
+
+    for (int i = 0; i < 4; i++)
+    {
+        snapshot->random.state[i] = GetU64(data + 16 + 8*i);
+    }
+
+    snapshot->score = GetU32(data + 48);
+    snapshot->best  = GetU32(data + 52);
+    snapshot->moves = GetU32(data + 56);
+    snapshot->max   = GetU32(data + 60);
+    snapshot->win   = data[64] != 0;
+}
+
+/*
+ * A game always has a tile on the board, the best score can't be below the
+ * current one and the all zero state is the only one the generator can't leave.
+ */
+static bool ValidateSnapshot(const JournalSnapshot *snapshot)
+{
+    const uint64_t *random = snapshot->random.state;
+
+    if (snapshot->cells == 0 || snapshot->max > BITBOARD_MAX_VALUE) return false;
+    if (snapshot->best < snapshot->score) return false;
+
+    return (random[0] | random[1] | random[2] | random[3]) != 0;
+}
+
+// Apply the move and the spawn, the generator must reproduce the recorded tile
+static bool ReplayMove(JournalSnapshot *state, unsigned char record)
+{
+    unsigned int score;
+    Bitboard cells = ExecuteMove(state->cells, record & 0x3, &score);
+
+    if (cells == state->cells) return false;
+
+    int cell = SpawnTile(&cells, &state->random);
+
+    if (cell != ((record >> 2) & 0xF) || GetCell(cells, cell) != 1u + ((record >> 6) & 1))
+    {
+        return false;
+    }
+
+    state->cells  = cells;
+    state->score += score;
+    state->moves++;
+
+    if (state->score > state->best) state->best = state->score;
+    if (GetMaxExponent(cells) > state->max) state->max = GetMaxExponent(cells);
+
+    return true;
+}
+
+// Flush the written records and sync them if the policy asks for it
+static int FinishWrite(Journal *journal)
+{
+    const SyncPolicy *policy = &journal->sync;
+    bool sync = false;
+
+    if (fflush(journal->file) != 0) return -1;
+
+    journal->unsynced++;
+
+    switch (policy->mode)
+    {
+    case SYNC_EVERY_MOVE:  sync = true; break;
+    case SYNC_EVERY_MOVES: sync = journal->unsynced >= policy->moves; break;
+    case SYNC_INTERVAL:    sync = GetMonotonicTime() - journal->synced >= policy->interval; break;
+    default: break;
+    }
+
+    if (!sync) return 0;
+
+    journal->unsynced = 0;
+    journal->synced   = GetMonotonicTime();
+    journal->syncs++;
+
+    return SyncFile(journal->file);
+}
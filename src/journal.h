@@ -0,0 +1,100 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>      // FILE
+#include <sys/param.h>  // PATH_MAX
+#include "bitboard.h"
+#include "random.h"
+
+/*
+ * Append-only move journal. The file starts with a header and a snapshot of
+ * the game state, every move appends a single byte with the direction and the
+ * spawned tile, every JOURNAL_SNAPSHOT_INTERVAL moves a new snapshot is
+ * appended. Recovery starts from the last complete snapshot and replays the
+ * moves after it, the spawns are replayed from the saved generator state and
+ * checked against the recorded ones, so a torn or corrupted tail is detected
+ * and dropped. The whole game can be replayed from the first snapshot.
+ * This module must not depend on raylib.
+ *
+ * The journal is only ever appended to or replaced as a whole: a new game and
+ * the compaction write the new journal to a temporary file, sync it and
+ * rename it over the old one, so a crash leaves either the old or the new
+ * journal. The header sequence number tells which one is newer if the crash
+ * happened before the rename. How often the appended data is synced to the
+ * disk is chosen by the sync policy, durability versus the cost per save.
+ *
+ * Records (all numbers little-endian, the cells are the 16 nibbles of the grid):
+ *   header    "2048" magic, version byte, sequence u32, CRC-32 of the header u32
+ *   move      0b0FCCCCDD - D direction, C spawn cell, F set if a 4 was spawned
+ *   snapshot  0x80 tag, cells u64, seed u64, random 4 x u64, score u32, best u32,
+ *             moves u32, max u32, win u8, CRC-32 of the tag and the fields u32
+ *
+ * Version 1 and 2 headers have no sequence and CRC-32, version 1 snapshots have
+ * no CRC-32, they are still loaded and the journal is rewritten in the current
+ * version on recovery. A snapshot is only accepted if
+ * the checksum matches and the state is consistent.
+ */
+
+#define JOURNAL_SNAPSHOT_INTERVAL  64     // Recovery replays at most this number of moves
+#define JOURNAL_VERSION            3
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    Bitboard cells;
+    uint64_t seed;
+    RandomGenerator random;
+    uint32_t score;
+    uint32_t best;
+    uint32_t moves;
+    uint32_t max;            // Highest tile exponent
+    bool win;
+} JournalSnapshot;
+
+typedef struct {
+    Direction direction;
+    int cell;                // Cell the tile was spawned to after the move
+    unsigned int value;      // Exponent of the spawned tile, 1 or 2
+} JournalMove;
+
+typedef enum { SYNC_NEVER, SYNC_EVERY_MOVE, SYNC_EVERY_MOVES, SYNC_INTERVAL } SyncMode;
+
+typedef struct {
+    SyncMode mode;
+    unsigned int moves;            // SYNC_EVERY_MOVES - writes between the syncs
+    double interval;               // SYNC_INTERVAL - seconds, checked when a write happens
+} SyncPolicy;
+
+typedef struct {
+    FILE *file;
+    const char *path;
+    char temp[PATH_MAX];           // New journals are prepared here and renamed over the path
+    uint32_t sequence;             // Incremented with every new journal
+    unsigned int interval;         // Moves between the snapshots
+    unsigned int pending;          // Moves appended since the last snapshot
+    SyncPolicy sync;
+    unsigned int unsynced;         // Writes since the last sync
+    double synced;                 // Monotonic time of the last sync
+    unsigned long long written;    // Bytes written since the journal was opened
+    unsigned long long syncs;      // Syncs since the journal was opened
+} Journal;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+int OpenJournal(Journal *journal, const char *path, unsigned int interval);
+void CloseJournal(Journal *journal);
+void SetJournalSyncPolicy(Journal *journal, SyncPolicy policy);
+int BackupJournal(Journal *journal);
+int StartJournal(Journal *journal, const JournalSnapshot *snapshot);
+int AppendJournalMove(Journal *journal, JournalMove move, const JournalSnapshot *state);
+int AppendJournalSnapshot(Journal *journal, const JournalSnapshot *snapshot);
+int RecoverJournal(Journal *journal, JournalSnapshot *snapshot);
+
+int WriteJournal(FILE *stream, const JournalSnapshot *snapshot);
+int ReplayJournal(FILE *stream, JournalSnapshot *snapshot, long *end);
+
+#endif  // JOURNAL_H
@@ -1,10 +1,31 @@
-#include <stdlib.h>     // realpath
-#include <string.h>     // strlen
+#include <stdio.h>      // snprintf
+#include <stdlib.h>     // realpath, atoi
+#include <string.h>     // strlen, strcmp
 #include "raylib.h"
 #include "game.h"
+#include "grid.h"
+#include "input.h"
+#include "profiler.h"
+#include "redraw.h"
 #include "resources.h"
+#include "timer.h"
 #include "screens/screens.h"
 
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+
+// Monotonic times of the startup steps, logged once the assets are loaded
+typedef struct {
+    double launched;               // Start of main()
+    double window;                 // Window and OpenGL context created
+    double audio;                  // Audio device opened
+    double resources;              // Asset loads started, or finished if they are synchronous
+    double game;                   // Game session and screens initialized
+    double firstFrame;             // First frame presented
+    bool reported;
+} StartupTrace;
+
 //-------------------------------------------------------------------------------------------------
 // Module Variables Definition
 //-------------------------------------------------------------------------------------------------
@@ -13,20 +34,42 @@ static const int screenHeight = 640;
 
 static const char *title = "2048";
 
+static const int targetFPS   = 0;     // Frames per second cap, 0 draws as fast as the vsync lets
+static const int maxSteps    = 8;     // Logic steps of a frame at most
+
+static const float transitionTime = 1/3.0f;    // Seconds of the fade out and of the fade in
+
+static StepClock stepClock;
+static InputScript inputScript;    // Synthetic moves of --input-script <path>
+static StartupTrace startup;
+
 static bool onTransition;
 static bool transFadeOut;
 static float transAlpha;
 static int transToScreen;
 static int framesCounter;
 
+#ifdef DEBUG
+static bool profilerVisible;
+static unsigned int profilerFrames;
+static ProfileStats profileStats[PROFILE_PHASE_COUNT];
+#endif
+
 //-------------------------------------------------------------------------------------------------
 // Local Module Functions Declaration
 //-------------------------------------------------------------------------------------------------
-void UpdateGame(void);  // Update game (one frame)
-void DrawGame(void);    // Draw game (one frame)
+void UpdateGame(Game *game);    // Update game (one frame)
+void StepGame(Game *game);      // Update game logic (one fixed step)
+void DrawGame(Game *game);      // Draw game (one frame)
 void UpdateTransition(void);
 void DrawTransition(void);
 void TransitionToScreen(const int screen);
+void TraceStartup(void);
+
+#ifdef DEBUG
+void UpdateProfiler(void);
+void DrawProfiler(void);
+#endif
 
 //-------------------------------------------------------------------------------------------------
 // Game main entry point
@@ -35,6 +78,23 @@ int main(int argc, char **argv)
 {
     // Initialization
     //---------------------------------------------------------------------------------------------
+    startup.launched = GetMonotonicTime();
+
+    Game game;    // The session shown in the window
+    int boardSize = BITBOARD_SIZE;
+    const char *inputScriptPath = NULL;
+    bool asyncAssets = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--sync-assets") == 0) asyncAssets = false;
+        else if (i + 1 < argc && strcmp(argv[i], "--size") == 0) boardSize = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--input-script") == 0)
+        {
+            inputScriptPath = argv[++i];
+        }
+    }
+
     onTransition  = false;
     transFadeOut  = false;
     transAlpha    = 0;
@@ -50,56 +110,127 @@ int main(int argc, char **argv)
 #endif
 
     // Initialize window and game screen
+    SetConfigFlags(FLAG_VSYNC_HINT);
     InitWindow(screenWidth, screenHeight, title);
+    startup.window = GetMonotonicTime();
+
     InitAudioDevice();
+    startup.audio = GetMonotonicTime();
+
+    // The loaders decode the assets meanwhile, the first frames use the fallbacks
+    InitResources(GetDirectoryPath(argv[0]), asyncAssets);
+    startup.resources = GetMonotonicTime();
 
-    InitResources(GetDirectoryPath(argv[0]));
+    if (boardSize < GRID_MIN_SIZE || boardSize > GRID_MAX_SIZE)
+    {
+        TraceLog(LOG_WARNING, "Board size must be %d to %d, playing %dx%d", GRID_MIN_SIZE,
+                 GRID_MAX_SIZE, BITBOARD_SIZE, BITBOARD_SIZE);
+        boardSize = BITBOARD_SIZE;
+    }
 
-    InitGame();
-    InitGameplayScreen();
+    InitGame(&game, boardSize, saveFilePath, historyFilePath);
+    TrackGameStats(&game);
+    InitGameplayScreen(&game);
     InitGameWinScreen();
 
+    // Replay the moves of an input script to measure the input latency
+    if (inputScriptPath)
+    {
+        if (LoadInputScript(&inputScript, inputScriptPath) == 0)
+        {
+            TraceLog(LOG_INFO, "Input script %s: %u moves", inputScriptPath, inputScript.count);
+            game.inputScript = &inputScript;
+        }
+        else
+        {
+            TraceLog(LOG_WARNING, "Input script %s can't be loaded", inputScriptPath);
+        }
+    }
+
     SetExitKey(0);
-    SetTargetFPS(60);
+    SetTargetFPS(targetFPS);
+
+    InitStepClock(&stepClock, GAME_STEP_TIME, maxSteps);
+
+    startup.game = GetMonotonicTime();
+
+    double started = GetMonotonicTime();
     //---------------------------------------------------------------------------------------------
 
     // Main game loop
     while (!WindowShouldClose())  // Detect window close button or ESC key
     {
+        // Blocks on the input events while nothing changes on the screen, nothing moves meanwhile
+        if (WaitForRedraw()) ResetStepClock(&stepClock);
+
+        int steps = AdvanceStepClock(&stepClock);
+
+#ifdef DEBUG
+        BeginProfileFrame();
+        UpdateProfiler();
+#endif
+
         // Update
         //-----------------------------------------------------------------------------------------
-        UpdateGame();
+        PROFILE_BEGIN(PROFILE_UPDATE);
+        if (UpdateResources()) RequestRedraw();    // Poll the loaders, draw the uploaded assets
+        UpdateGame(&game);
+        for (int i = 0; i < steps; i++) StepGame(&game);
+        DispatchEvents(&game.events);    // The saves, the stats and the sounds of the frame
+        PROFILE_END(PROFILE_UPDATE);
         //-----------------------------------------------------------------------------------------
 
         // Draw
         //-----------------------------------------------------------------------------------------
-        DrawGame();
+        PROFILE_BEGIN(PROFILE_DRAW);
+        DrawGame(&game);
+        PROFILE_END(PROFILE_DRAW);
+
+        if (!startup.reported) TraceStartup();
         //-----------------------------------------------------------------------------------------
     }
 
     // De-Initialization
     //---------------------------------------------------------------------------------------------
-    CloseAudioDevice();
-    CloseWindow();  // Close window and OpenGL context
+    RedrawStats redraw = GetRedrawStats();
+    double elapsed = GetMonotonicTime() - started;
+
+    TraceLog(LOG_INFO, "Frames: %llu in %.1f s (%.1f wakeups/s), %llu waited for input "
+             "(%llu timeouts, %.1f s idle), CPU usage %.1f%%", redraw.frames, elapsed,
+             redraw.frames / elapsed, redraw.waits, redraw.timeouts, redraw.idleTime,
+             GetProcessCpuTime() / elapsed * 100);
 
-    UnloadGameplayScreen();
+    InputStats input = game.input.stats;
+
+    TraceLog(LOG_INFO, "Input: %llu moves, %llu applied, %llu dropped, key to state latency "
+             "%.2f ms average, %.2f ms max", input.received, input.applied, input.dropped,
+             input.applied ? input.totalLatency / input.applied * 1000 : 0,
+             input.maxLatency * 1000);
+
+    game.inputScript = NULL;
+    UnloadInputScript(&inputScript);
+
+    UnloadGameplayScreen(&game);  // Unloads textures, needs the OpenGL context
     UnloadGameWinScreen();
-    UnloadGame();
+    UnloadGame(&game);
     UnloadResources();
 
+    CloseAudioDevice();
+    CloseWindow();  // Close window and OpenGL context
+
     //---------------------------------------------------------------------------------------------
 
     return 0;
 }
 
-void UpdateGame(void)
+void UpdateGame(Game *game)
 {
     if (!onTransition)
     {
         switch (currentScreen)
         {
-            case SCREEN_PLAY: UpdateGameplayScreen(); break;
-            case SCREEN_WIN: UpdateGameWinScreen(); break;
+            case SCREEN_PLAY: UpdateGameplayScreen(game); break;
+            case SCREEN_WIN: UpdateGameWinScreen(game); break;
             default: break;
         }
 
@@ -108,19 +239,33 @@ void UpdateGame(void)
             TransitionToScreen(nextScreen);
         }
     }
+
+    if (onTransition) RequestRedraw();
+}
+
+void StepGame(Game *game)
+{
+    if (!onTransition)
+    {
+        switch (currentScreen)
+        {
+            case SCREEN_PLAY: StepGameplayScreen(game); break;
+            default: break;
+        }
+    }
     else
     {
         UpdateTransition();
     }
 }
 
-void DrawGame(void)
+void DrawGame(Game *game)
 {
     BeginDrawing();
 
     switch (currentScreen)
     {
-        case SCREEN_PLAY: DrawGameplayScreen(); break;
+        case SCREEN_PLAY: DrawGameplayScreen(game, stepClock.lag); break;
         case SCREEN_WIN: DrawGameWinScreen(); break;
         default: break;
     }
@@ -132,6 +277,7 @@ void DrawGame(void)
 
 #ifdef DEBUG
     DrawFPS(5, 5);
+    if (profilerVisible) DrawProfiler();
 #endif
 
     EndDrawing();
@@ -147,7 +293,7 @@ void UpdateTransition(void)
 {
     if (!transFadeOut)
     {
-        if ((transAlpha += 0.05f) >= 1.0f)
+        if ((transAlpha += GAME_STEP_TIME/transitionTime) >= 1.0f)
         {
             transAlpha    = 1.0f;
             transFadeOut  = true;
@@ -157,7 +303,7 @@ void UpdateTransition(void)
     }
     else  // Transition fade out logic
     {
-        if ((transAlpha -= 0.05f) <= 0)
+        if ((transAlpha -= GAME_STEP_TIME/transitionTime) <= 0)
         {
             transAlpha    = 0;
             transFadeOut  = false;
@@ -171,3 +317,99 @@ void DrawTransition(void)
 {
     DrawRectangle(0, 0, screenWidth, screenHeight, Fade(COLOR_SCREEN, transAlpha));
 }
+
+/*
+ * Record the first frame and log the startup steps in milliseconds from the
+ * start of main() once every asset is loaded. --sync-assets loads them before
+ * the first frame instead, the way it was done before, to compare against.
+ */
+void TraceStartup(void)
+{
+    if (!startup.firstFrame)
+    {
+        startup.firstFrame = GetMonotonicTime();
+#ifdef DEBUG
+        RecordProfileZone(PROFILE_STARTUP, startup.launched, startup.firstFrame);
+#endif
+    }
+
+    ResourceStats resources = GetResourceStats();
+
+    if (!resources.loaded) return;
+
+    TraceLog(LOG_INFO, "Startup: window %.1f ms, audio %.1f ms, resources %.1f ms, game %.1f ms, "
+             "first frame %.1f ms, assets loaded %.1f ms (%s, font %s, %.1f ms decoding, "
+             "%.1f ms uploading, %d failed)", (startup.window - startup.launched) * 1000,
+             (startup.audio - startup.launched) * 1000,
+             (startup.resources - startup.launched) * 1000,
+             (startup.game - startup.launched) * 1000,
+             (startup.firstFrame - startup.launched) * 1000,
+             (resources.loaded - startup.launched) * 1000,
+             resources.async ? "async" : "sync",
+             resources.fontCached ? "from the cache" : "rasterized", resources.decodeTime * 1000,
+             resources.uploadTime * 1000, resources.failed);
+
+    startup.reported = true;
+}
+
+#ifdef DEBUG
+/*
+ * F3 toggles the frame phase overlay, F4 exports the recorded frames as CSV
+ * and as a Chrome trace (chrome://tracing) next to the game save.
+ */
+void UpdateProfiler(void)
+{
+    if (IsKeyPressed(KEY_F3))
+    {
+        profilerVisible = !profilerVisible;
+        profilerFrames  = 0;
+    }
+
+    // The statistics are sorted, refresh them twice a second only
+    if (profilerVisible && profilerFrames++ % 30 == 0) GetProfileStats(profileStats, 120);
+
+    if (profilerVisible) RequestRedraw();    // The overlay is live
+
+    if (IsKeyPressed(KEY_F4))
+    {
+        char csvPath[PATH_MAX];
+        char tracePath[PATH_MAX];
+
+        // A save directory too long for the paths isn't written to a truncated path
+        if (snprintf(csvPath, sizeof(csvPath), "%s/profile.csv", saveDirPath) < PATH_MAX &&
+            snprintf(tracePath, sizeof(tracePath), "%s/profile.json", saveDirPath) < PATH_MAX &&
+            ExportProfileCsv(csvPath) == 0 && ExportProfileTrace(tracePath) == 0)
+        {
+            TraceLog(LOG_INFO, "Profile was exported to %s and %s", csvPath, tracePath);
+        }
+        else
+        {
+            TraceLog(LOG_WARNING, "Can't export the profile to %s", saveDirPath);
+        }
+    }
+}
+
+// Min, average and 99th percentile of every phase over the last 120 frames, in milliseconds
+void DrawProfiler(void)
+{
+    static const char *columns[] = { "phase", "min", "avg", "p99", "count" };
+    static const int x[] = { 5, 110, 170, 230, 290 };
+    int y = 30;
+
+    DrawRectangle(0, y - 5, screenWidth, 24 + PROFILE_PHASE_COUNT*14, Fade(BLACK, 0.7f));
+
+    for (int i = 0; i < 5; i++) DrawText(columns[i], x[i], y, 10, YELLOW);
+
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++)
+    {
+        ProfileStats *stats = &profileStats[phase];
+
+        y += 14;
+        DrawText(GetProfilePhaseName(phase), x[0], y, 10, WHITE);
+        DrawText(FormatText("%.3f", stats->min * 1e3), x[1], y, 10, WHITE);
+        DrawText(FormatText("%.3f", stats->avg * 1e3), x[2], y, 10, WHITE);
+        DrawText(FormatText("%.3f", stats->p99 * 1e3), x[3], y, 10, WHITE);
+        DrawText(FormatText("%u", stats->count), x[4], y, 10, WHITE);
+    }
+}
+#endif
@@ -0,0 +1,240 @@
+#include <stdbool.h>
+#include <stdio.h>   // fopen, fprintf, fclose
+#include <stdlib.h>  // qsort
+#include "profiler.h"
+
+#define THREAD_GAME  1
+#define THREAD_SAVE  2
+#define THREAD_FONT  3
+#define THREAD_SOUND 4
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    uint64_t sequence;       // Odd while the zone is written, 2*index + 2 once it is complete
+    ProfileZone zone;
+} ProfileSlot;
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static ProfileSlot ring[PROFILER_CAPACITY];
+static uint64_t head;            // Zones ever recorded, the next one goes to head % capacity
+static uint32_t frame;           // Current frame number, changed by the game thread only
+static double frameStart;
+
+static ProfileZone zones[PROFILER_CAPACITY];    // Copy of the ring for the readers
+static double durations[PROFILER_CAPACITY];
+
+static const char *phaseNames[PROFILE_PHASE_COUNT] = {
+    "frame", "update", "draw", "draw_board", "rounded_rect", "text", "save", "save_write",
+    "startup", "font_load", "sound_load", "asset_upload"
+};
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static unsigned int CopyZones(uint32_t firstFrame);
+static double GetOrigin(unsigned int count);
+static int GetZoneThread(ProfilePhase phase);
+static int CompareDurations(const void *a, const void *b);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Close the previous frame, call once at the beginning of every frame
+void BeginProfileFrame(void)
+{
+    double now = GetMonotonicTime();
+
+    if (frameStart > 0) RecordProfileZone(PROFILE_FRAME, frameStart, now);
+
+    __atomic_store_n(&frame, frame + 1, __ATOMIC_RELAXED);
+    frameStart = now;
+}
+
+/*
+ * Claim a slot and publish the zone, never blocks. A writer that falls a
+ * whole ring behind only makes the reader skip its zone.
+ */
+void RecordProfileZone(ProfilePhase phase, double start, double end)
+{
+    uint64_t index = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+    ProfileSlot *slot = &ring[index & (PROFILER_CAPACITY - 1)];
+
+    __atomic_store_n(&slot->sequence, 2*index + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    ProfileZone zone = { start, end, __atomic_load_n(&frame, __ATOMIC_RELAXED), phase };
+
+    __atomic_store(&slot->zone.start, &zone.start, __ATOMIC_RELAXED);
+    __atomic_store(&slot->zone.end, &zone.end, __ATOMIC_RELAXED);
+    __atomic_store(&slot->zone.frame, &zone.frame, __ATOMIC_RELAXED);
+    __atomic_store(&slot->zone.phase, &zone.phase, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot->sequence, 2*index + 2, __ATOMIC_RELEASE);
+}
+
+// Duration statistics of every phase over the last complete frames
+void GetProfileStats(ProfileStats stats[PROFILE_PHASE_COUNT], unsigned int frames)
+{
+    uint32_t firstFrame = (frame > frames) ? frame - frames : 0;
+    unsigned int count = CopyZones(firstFrame);
+
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++)
+    {
+        unsigned int n = 0;
+        double sum = 0;
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            // The current frame isn't complete yet
+            if (zones[i].phase != (ProfilePhase)phase || zones[i].frame == frame) continue;
+
+            durations[n] = zones[i].end - zones[i].start;
+            sum += durations[n++];
+        }
+
+        stats[phase] = (ProfileStats){ 0 };
+        if (n == 0) continue;
+
+        qsort(durations, n, sizeof(double), CompareDurations);
+
+        stats[phase].count = n;
+        stats[phase].min   = durations[0];
+        stats[phase].avg   = sum / n;
+        stats[phase].p99   = durations[(n - 1)*99/100];
+    }
+}
+
+const char * GetProfilePhaseName(ProfilePhase phase)
+{
+    return (phase < PROFILE_PHASE_COUNT) ? phaseNames[phase] : "unknown";
+}
+
+// Write every zone still in the ring, the times are milliseconds from the oldest zone
+int ExportProfileCsv(const char *path)
+{
+    unsigned int count = CopyZones(0);
+    double origin = GetOrigin(count);
+    FILE *file = fopen(path, "w");
+
+    if (!file) return -1;
+
+    fprintf(file, "frame,phase,start_ms,duration_ms\n");
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        fprintf(file, "%u,%s,%.4f,%.4f\n", zones[i].frame, phaseNames[zones[i].phase],
+                (zones[i].start - origin) * 1e3, (zones[i].end - zones[i].start) * 1e3);
+    }
+
+    return (fclose(file) == 0) ? 0 : -1;
+}
+
+// Write every zone still in the ring in the Chrome trace event format (chrome://tracing)
+int ExportProfileTrace(const char *path)
+{
+    unsigned int count = CopyZones(0);
+    double origin = GetOrigin(count);
+    FILE *file = fopen(path, "w");
+
+    if (!file) return -1;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":\"game\"}},\n", THREAD_GAME);
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":\"save\"}},\n", THREAD_SAVE);
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":\"font_loader\"}},\n", THREAD_FONT);
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":\"sound_loader\"}}", THREAD_SOUND);
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        int thread = GetZoneThread(zones[i].phase);
+
+        fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,"
+                "\"tid\":%d,\"args\":{\"frame\":%u}}", phaseNames[zones[i].phase],
+                (zones[i].start - origin) * 1e6, (zones[i].end - zones[i].start) * 1e6, thread,
+                zones[i].frame);
+    }
+
+    fprintf(file, "\n]}\n");
+
+    return (fclose(file) == 0) ? 0 : -1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+/*
+ * Copy the complete zones of the frames starting at the first one, oldest
+ * first. A slot rewritten while it was copied has a different sequence
+ * afterwards and is skipped.
+ */
+static unsigned int CopyZones(uint32_t firstFrame)
+{
+    uint64_t last  = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    uint64_t first = (last > PROFILER_CAPACITY) ? last - PROFILER_CAPACITY : 0;
+    unsigned int count = 0;
+
+    for (uint64_t index = first; index < last; index++)
+    {
+        ProfileSlot *slot = &ring[index & (PROFILER_CAPACITY - 1)];
+        uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+
+        if (sequence != 2*index + 2) continue;
+
+        ProfileZone zone;
+
+        __atomic_load(&slot->zone.start, &zone.start, __ATOMIC_RELAXED);
+        __atomic_load(&slot->zone.end, &zone.end, __ATOMIC_RELAXED);
+        __atomic_load(&slot->zone.frame, &zone.frame, __ATOMIC_RELAXED);
+        __atomic_load(&slot->zone.phase, &zone.phase, __ATOMIC_RELAXED);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) != sequence) continue;
+
+        if (zone.frame >= firstFrame) zones[count++] = zone;
+    }
+
+    return count;
+}
+
+// Earliest start of the copied zones, the zones are ordered by their end
+static double GetOrigin(unsigned int count)
+{
+    double origin = count ? zones[0].start : 0;
+
+    for (unsigned int i = 1; i < count; i++)
+    {
+        if (zones[i].start < origin) origin = zones[i].start;
+    }
+
+    return origin;
+}
+
+// Thread the zones of the phase are recorded on
+static int GetZoneThread(ProfilePhase phase)
+{
+    switch (phase)
+    {
+    case PROFILE_SAVE_WRITE: return THREAD_SAVE;
+    case PROFILE_FONT_LOAD:  return THREAD_FONT;
+    case PROFILE_SOUND_LOAD: return THREAD_SOUND;
+    default:                 return THREAD_GAME;
+    }
+}
+
+static int CompareDurations(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
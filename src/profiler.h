@@ -0,0 +1,75 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include "timer.h"
+
+/*
+ * Frame phase profiler. Scoped timers record zones into a lock-free ring
+ * buffer, any thread can record, the game thread reads the statistics for
+ * the overlay and exports the recorded frames. The macros compile to nothing
+ * unless DEBUG is defined.
+ * This module must not depend on raylib.
+ */
+
+#define PROFILER_CAPACITY  16384    // Zones, must be a power of two
+
+#ifdef DEBUG
+    #define PROFILE_BEGIN(phase)    double profileStart##phase = GetMonotonicTime()
+    #define PROFILE_END(phase)      RecordProfileZone(phase, profileStart##phase, GetMonotonicTime())
+    #define PROFILE_CALL(phase, call) do {                                         \
+            double profileStart = GetMonotonicTime();                              \
+            call;                                                                  \
+            RecordProfileZone(phase, profileStart, GetMonotonicTime());            \
+        } while (0)
+#else
+    #define PROFILE_BEGIN(phase)    ((void)0)
+    #define PROFILE_END(phase)      ((void)0)
+    #define PROFILE_CALL(phase, call) call
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef enum {
+    PROFILE_FRAME,           // Whole frame, from one BeginProfileFrame() to the next
+    PROFILE_UPDATE,
+    PROFILE_DRAW,
+    PROFILE_DRAW_BOARD,
+    PROFILE_ROUNDED_RECT,    // Every DrawRoundedRectangleRec() call
+    PROFILE_TEXT,            // Every text draw call
+    PROFILE_SAVE,            // Save submission on the game thread
+    PROFILE_SAVE_WRITE,      // Journal write on the save thread
+    PROFILE_STARTUP,         // From the start of main() to the first frame on the screen
+    PROFILE_FONT_LOAD,       // Font rasterization on its loader thread
+    PROFILE_SOUND_LOAD,      // Sound decoding on its loader thread
+    PROFILE_ASSET_UPLOAD,    // Texture or sound upload of a loaded asset
+    PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+typedef struct {
+    double start;
+    double end;
+    uint32_t frame;
+    ProfilePhase phase;
+} ProfileZone;
+
+typedef struct {
+    unsigned int count;      // Zones in the measured frames
+    double min;              // Seconds
+    double avg;
+    double p99;
+} ProfileStats;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+void BeginProfileFrame(void);
+void RecordProfileZone(ProfilePhase phase, double start, double end);
+void GetProfileStats(ProfileStats stats[PROFILE_PHASE_COUNT], unsigned int frames);
+const char * GetProfilePhaseName(ProfilePhase phase);
+
+int ExportProfileCsv(const char *path);
+int ExportProfileTrace(const char *path);
+
+#endif  // PROFILER_H
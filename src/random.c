@@ -0,0 +1,117 @@
+#include <time.h>  // time
+#include "random.h"
+#include "timer.h"
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static inline uint64_t RotateLeft(uint64_t value, int shift);
+static inline uint64_t SplitMix(uint64_t *value);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+/*
+ * Expand the seed into the state with splitmix64, as recommended by the
+ * xoshiro authors. Any seed, zero included, gives a valid non-zero state.
+ */
+void SeedRandomGenerator(RandomGenerator *random, uint64_t seed)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        random->state[i] = SplitMix(&seed);
+    }
+}
+
+// Equivalent to 2^128 calls of NextRandom()
+void JumpRandomGenerator(RandomGenerator *random)
+{
+    static const uint64_t jump[4] = {
+        0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+    };
+    uint64_t state[4] = { 0 };
+
+    for (int i = 0; i < 4; i++)
+    {
+        for (int bit = 0; bit < 64; bit++)
+        {
+            if (jump[i] & ((uint64_t)1 << bit))
+            {
+                state[0] ^= random->state[0];
+                state[1] ^= random->state[1];
+                state[2] ^= random->state[2];
+                state[3] ^= random->state[3];
+            }
+            NextRandom(random);
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        random->state[i] = state[i];
+    }
+}
+
+uint64_t NextRandom(RandomGenerator *random)
+{
+    uint64_t *s = random->state;
+    uint64_t result = RotateLeft(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = RotateLeft(s[3], 45);
+
+    return result;
+}
+
+/*
+ * Lemire's multiply and shift reduction. The few low products that would
+ * make some results more likely are rejected, so the result is unbiased
+ * unlike the modulo of the raw value.
+ */
+uint32_t NextRandomBelow(RandomGenerator *random, uint32_t bound)
+{
+    uint64_t product = (NextRandom(random) >> 32) * bound;
+
+    if ((uint32_t)product < bound)
+    {
+        uint32_t threshold = -bound % bound;
+
+        while ((uint32_t)product < threshold)
+        {
+            product = (NextRandom(random) >> 32) * bound;
+        }
+    }
+
+    return (uint32_t)(product >> 32);
+}
+
+uint64_t GetTimeSeed(void)
+{
+    uint64_t seed = (uint64_t)time(NULL);
+
+    return SplitMix(&seed) ^ (uint64_t)(GetMonotonicTime() * 1e9);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+static inline uint64_t RotateLeft(uint64_t value, int shift)
+{
+    return (value << shift) | (value >> (64 - shift));
+}
+
+static inline uint64_t SplitMix(uint64_t *value)
+{
+    uint64_t z = (*value += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
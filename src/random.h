@@ -0,0 +1,31 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+/*
+ * Small seedable xoshiro256** generator. The whole state lives in the struct,
+ * so every game and every simulation worker owns its generator and a seed
+ * replays the same game. JumpRandomGenerator() advances the state by 2^128
+ * steps, the streams produced by consecutive jumps never overlap in practice,
+ * this is how parallel workers get independent streams from a single seed.
+ * This module must not depend on raylib.
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    uint64_t state[4];
+} RandomGenerator;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+void SeedRandomGenerator(RandomGenerator *random, uint64_t seed);
+void JumpRandomGenerator(RandomGenerator *random);
+uint64_t NextRandom(RandomGenerator *random);
+uint32_t NextRandomBelow(RandomGenerator *random, uint32_t bound);    // Uniform in [0, bound)
+uint64_t GetTimeSeed(void);    // Seed for games that don't need to be replayed
+
+#endif  // RANDOM_H
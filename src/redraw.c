@@ -0,0 +1,58 @@
+#include "redraw.h"
+#include "timer.h"
+
+#if defined(PLATFORM_DESKTOP)
+    // GLFW is linked into raylib on the desktop platforms, raylib's callbacks record the events
+    void glfwWaitEventsTimeout(double timeout);
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static bool requested = true;      // The first frame is always drawn
+static RedrawStats stats;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// The frame after the current one has to be drawn
+void RequestRedraw(void)
+{
+    requested = true;
+}
+
+/*
+ * Call before every frame. Returns false at once if the frame was requested,
+ * otherwise waits until an input event arrives or the timeout elapses and
+ * returns true.
+ */
+bool WaitForRedraw(void)
+{
+    stats.frames++;
+
+    if (requested)
+    {
+        requested = false;
+        return false;
+    }
+
+#if defined(PLATFORM_DESKTOP)
+    double start = GetMonotonicTime();
+
+    glfwWaitEventsTimeout(REDRAW_IDLE_TIMEOUT);
+
+    double waited = GetMonotonicTime() - start;
+
+    stats.waits++;
+    stats.idleTime += waited;
+    if (waited >= REDRAW_IDLE_TIMEOUT) stats.timeouts++;
+#endif
+
+    return true;
+}
+
+RedrawStats GetRedrawStats(void)
+{
+    return stats;
+}
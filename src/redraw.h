@@ -0,0 +1,32 @@
+#ifndef REDRAW_H
+#define REDRAW_H
+
+#include <stdbool.h>
+
+/*
+ * Idle rendering. Whatever animates or changes on the screen requests the
+ * next frame, a frame nobody requested would be the same as the last one, so
+ * the main loop blocks on the input events instead (or until the timeout)
+ * and only runs a frame once something happens.
+ */
+
+#define REDRAW_IDLE_TIMEOUT  1.0    // Seconds, longest wait for an input event
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    unsigned long long frames;     // Frames run
+    unsigned long long waits;      // Frames that waited for an event first
+    unsigned long long timeouts;   // Waits that ended with no event
+    double idleTime;               // Seconds spent waiting
+} RedrawStats;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+void RequestRedraw(void);
+bool WaitForRedraw(void);
+RedrawStats GetRedrawStats(void);
+
+#endif  // REDRAW_H
@@ -1,6 +1,46 @@
-#include <stdlib.h>  // getenv
+#include <pthread.h>
+#include <stdio.h>   // snprintf
+#include <stdlib.h>  // getenv, free
 #include <string.h>  // strcpy, strcat
+#include "fontcache.h"
+#include "profiler.h"
 #include "resources.h"
+#include "textcache.h"
+#include "timer.h"
+#include "utils.h"
+
+#define FONT_SIZE      124
+#define FONT_CHARS     95       // The printable ASCII characters
+#define FONT_PADDING   2        // Pixels around every glyph of the atlas
+
+#define ASSET_COUNT    (int)(sizeof(assets) / sizeof(assets[0]))
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef enum { ASSET_FONT, ASSET_SOUND, ASSET_TYPE_COUNT } AssetType;
+
+typedef struct {
+    AssetType type;
+    const char *file;              // Relative to the resources directory
+    Sound *sound;                  // Target of a sound asset
+    char path[PATH_MAX];
+    int ready;                     // Set by the loader once decoded, accessed with __atomic
+    bool finished;                 // Uploaded or failed, the decoded data is released
+    bool uploaded;
+    Wave wave;                     // Decoded sound
+    CharInfo *chars;               // Rasterized glyphs and the atlas they were packed into
+    Image atlas;
+    bool cached;                   // The font was loaded from the baked atlas cache
+    double decodeTime;             // Seconds the loader took
+} Asset;
+
+// A loader thread per asset type, the font alone takes longer than all the sounds
+typedef struct {
+    pthread_t thread;
+    AssetType type;
+    bool started;
+} AssetLoader;
 
 //-------------------------------------------------------------------------------------------------
 // Local Variables Definition
@@ -14,19 +54,42 @@ Font textFont;
 
 char saveDirPath[PATH_MAX];
 char saveFilePath[PATH_MAX];
+char historyFilePath[PATH_MAX];
+
+static Asset assets[] = {
+    { .type = ASSET_FONT,  .file = "fonts/ClearSans-Bold.ttf" },
+    { .type = ASSET_SOUND, .file = "audio/move.wav",   .sound = &moveSound },
+    { .type = ASSET_SOUND, .file = "audio/merge.wav",  .sound = &mergeSound },
+    { .type = ASSET_SOUND, .file = "audio/action.wav", .sound = &actionSound },
+    { .type = ASSET_SOUND, .file = "audio/appear.wav", .sound = &appearSound },
+};
+
+static char fontCachePath[PATH_MAX];
+
+static AssetLoader loaders[ASSET_TYPE_COUNT];
+static ResourceStats stats;
 
 //-------------------------------------------------------------------------------------------------
 // Local Functions Declaration
 //-------------------------------------------------------------------------------------------------
-void LoadSFX(const char *absolutepath);
-void UnloadSFX(void);
-void LoadFonts(const char *absolutepath);
-void UnloadFonts(void);
+static void *LoaderMain(void *arg);
+static void DecodeAsset(Asset *asset);
+static void DecodeFont(Asset *asset);
+static void UnpackFontCache(Asset *asset, FontCache *cache);
+static int BakeFontCache(const Asset *asset, const FontCacheKey *key);
+static void UploadAsset(Asset *asset);
+static void ReleaseAsset(Asset *asset);
+static void JoinLoaders(void);
 
 //-------------------------------------------------------------------------------------------------
 // Functions Definition
 //-------------------------------------------------------------------------------------------------
-void InitResources(const char *absolutepath)
+
+/*
+ * Set the save paths and start loading the assets, in the background if
+ * async is set. The synchronous load is kept to measure the startup against.
+ */
+void InitResources(const char *absolutepath, bool async)
 {
 #if defined(PLATFORM_WINDOWS)
     // Define game absolute save dir path
@@ -36,6 +99,14 @@ void InitResources(const char *absolutepath)
     // Define game absolute save file path
     strcpy(saveFilePath, saveDirPath);
     strcat(saveFilePath, "\\storage.data");
+
+    // Define game absolute undo history file path
+    strcpy(historyFilePath, saveDirPath);
+    strcat(historyFilePath, "\\history.data");
+
+    // Define game absolute font atlas cache file path
+    strcpy(fontCachePath, saveDirPath);
+    strcat(fontCachePath, "\\font.cache");
 #elif defined(PLATFORM_OSX)
     // Define game absolute save dir path
     strcpy(saveDirPath, getenv("HOME"));
@@ -44,74 +115,343 @@ void InitResources(const char *absolutepath)
     // Define game absolute save file path
     strcpy(saveFilePath, saveDirPath);
     strcat(saveFilePath, "/storage.data");
+
+    // Define game absolute undo history file path
+    strcpy(historyFilePath, saveDirPath);
+    strcat(historyFilePath, "/history.data");
+
+    // Define game absolute font atlas cache file path
+    strcpy(fontCachePath, saveDirPath);
+    strcat(fontCachePath, "/font.cache");
 #else
     #error Platform is undefined
 #endif
 
     TraceLog(LOG_DEBUG, "Save path: %s", saveFilePath);
 
-    LoadSFX(absolutepath);
-    LoadFonts(absolutepath);
+    MakeSaveDir(saveDirPath);  // Create save data directory if not exist, holds the font cache
+
+    stats = (ResourceStats){ .queued = GetMonotonicTime(), .async = async };
+
+    textFont = GetFontDefault();    // Drawn with until the font is uploaded
+
+    for (int i = 0; i < ASSET_COUNT; i++)
+    {
+        Asset *asset = &assets[i];
+
+        *asset = (Asset){ .type = asset->type, .file = asset->file, .sound = asset->sound };
+
+#if defined(BUNDLE_OSX)
+        // Load from the OSX bundle
+        snprintf(asset->path, PATH_MAX, "%s/../resources/%s", absolutepath, asset->file);
+#else
+        snprintf(asset->path, PATH_MAX, "resources/%s", asset->file);
+#endif
+    }
+
+#if !defined(BUNDLE_OSX)
+    (void)absolutepath;
+#endif
+
+    for (int type = 0; async && type < ASSET_TYPE_COUNT; type++)
+    {
+        AssetLoader *loader = &loaders[type];
+
+        loader->type    = type;
+        loader->started = (pthread_create(&loader->thread, NULL, LoaderMain, loader) == 0);
+
+        if (!loader->started) TraceLog(LOG_WARNING, "Assets are loaded on the main thread");
+    }
+
+    // The assets of a loader that didn't start are loaded right away
+    for (int i = 0; i < ASSET_COUNT; i++)
+    {
+        if (!loaders[assets[i].type].started) DecodeAsset(&assets[i]);
+    }
+
+    UpdateResources();
+}
+
+/*
+ * Upload the assets the loaders finished, call once per frame on the main
+ * thread. Returns true while the assets load or if one was uploaded, the
+ * next frame is drawn with it.
+ */
+bool UpdateResources(void)
+{
+    if (stats.loaded) return false;
+
+    int finished = 0;
+
+    for (int i = 0; i < ASSET_COUNT; i++)
+    {
+        Asset *asset = &assets[i];
+
+        if (!asset->finished && __atomic_load_n(&asset->ready, __ATOMIC_ACQUIRE))
+        {
+            UploadAsset(asset);
+        }
+
+        finished += asset->finished;
+    }
+
+    if (finished == ASSET_COUNT)
+    {
+        JoinLoaders();
+        stats.loaded = GetMonotonicTime();
+    }
+
+    return true;
 }
 
 void UnloadResources(void)
 {
-    UnloadSFX();
-    UnloadFonts();
+    JoinLoaders();
+
+    for (int i = 0; i < ASSET_COUNT; i++)
+    {
+        Asset *asset = &assets[i];
+
+        if (!asset->uploaded) ReleaseAsset(asset);
+        else if (asset->type == ASSET_FONT) UnloadFont(textFont);
+        else UnloadSound(*asset->sound);
+
+        *asset = (Asset){ .type = asset->type, .file = asset->file, .sound = asset->sound };
+    }
+
+    stats.loaded = 0;
+}
+
+ResourceStats GetResourceStats(void)
+{
+    return stats;
+}
+
+// Play the sound once it is uploaded, it is silent until then
+void PlaySFX(const Sound *sound)
+{
+    for (int i = 0; i < ASSET_COUNT; i++)
+    {
+        if (assets[i].sound == sound && assets[i].uploaded) PlaySound(*sound);
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
 // Local Functions Definition
 //-------------------------------------------------------------------------------------------------
-void LoadSFX(const char *absolutepath)
+static void *LoaderMain(void *arg)
 {
-#if defined(BUNDLE_OSX)
-    char filepath[PATH_MAX];
+    AssetLoader *loader = arg;
+
+    for (int i = 0; i < ASSET_COUNT; i++)
+    {
+        if (assets[i].type == loader->type) DecodeAsset(&assets[i]);
+    }
+
+    return NULL;
+}
 
-    // Load sounds from OSX bundle
-    strcpy(filepath, absolutepath);
-    moveSound = LoadSound(strcat(filepath, "/../resources/audio/move.wav"));
+// Read and decode the file without touching the GPU or the audio device, runs on a loader thread
+static void DecodeAsset(Asset *asset)
+{
+    double start = GetMonotonicTime();
 
-    strcpy(filepath, absolutepath);
-    mergeSound = LoadSound(strcat(filepath, "/../resources/audio/merge.wav"));
+    if (asset->type == ASSET_SOUND)
+    {
+        asset->wave = LoadWave(asset->path);
+    }
+    else
+    {
+        DecodeFont(asset);
+    }
 
-    strcpy(filepath, absolutepath);
-    actionSound = LoadSound(strcat(filepath, "/../resources/audio/action.wav"));
+    double end = GetMonotonicTime();
 
-    strcpy(filepath, absolutepath);
-    appearSound = LoadSound(strcat(filepath, "/../resources/audio/appear.wav"));
-#else
-    // Load sounds
-    actionSound = LoadSound("resources/audio/action.wav");
-    appearSound = LoadSound("resources/audio/appear.wav");
-    moveSound = LoadSound("resources/audio/move.wav");
-    mergeSound = LoadSound("resources/audio/merge.wav");
+#ifdef DEBUG
+    RecordProfileZone((asset->type == ASSET_FONT) ? PROFILE_FONT_LOAD : PROFILE_SOUND_LOAD,
+                      start, end);
 #endif
+
+    asset->decodeTime = end - start;
+
+    __atomic_store_n(&asset->ready, 1, __ATOMIC_RELEASE);
 }
 
-void UnloadSFX(void)
+/*
+ * Take the glyphs and the atlas from the baked cache if it matches the font
+ * file. Otherwise rasterize the glyphs and pack them into the atlas image the
+ * way LoadFontEx() does it, and bake the cache for the next launches.
+ */
+static void DecodeFont(Asset *asset)
 {
-    UnloadSound(actionSound);
-    UnloadSound(appearSound);
-    UnloadSound(moveSound);
-    UnloadSound(mergeSound);
+    FontCacheKey key;
+    FontCache cache;
+    bool keyed = (GetFontCacheKey(&key, asset->path, FONT_SIZE, FONT_CHARS, FONT_PADDING) == 0);
+
+    if (keyed && LoadFontCache(&cache, fontCachePath, &key) == 0)
+    {
+        UnpackFontCache(asset, &cache);
+        UnloadFontCache(&cache);
+
+        if (asset->cached) return;
+    }
+
+    asset->chars = LoadFontData(asset->path, FONT_SIZE, NULL, FONT_CHARS, FONT_DEFAULT);
+
+    if (asset->chars)
+    {
+        asset->atlas = GenImageFontAtlas(asset->chars, FONT_SIZE, FONT_CHARS, FONT_PADDING, 0);
+    }
+
+    if (keyed && asset->atlas.data && BakeFontCache(asset, &key) != 0)
+    {
+        TraceLog(LOG_WARNING, "Font cache %s can't be written", fontCachePath);
+    }
 }
 
-void LoadFonts(const char *absolutepath)
+// The glyphs keep no bitmaps, only the atlas is drawn from
+static void UnpackFontCache(Asset *asset, FontCache *cache)
 {
-#if defined(BUNDLE_OSX)
-    char filepath[PATH_MAX];
+    if (cache->pixelBytes != (uint32_t)GetPixelDataSize(cache->width, cache->height,
+                                                        cache->format))
+    {
+        return;
+    }
 
-    strcpy(filepath, absolutepath);
-    textFont = LoadFontEx(strcat(filepath, "/../resources/fonts/ClearSans-Bold.ttf"), 124, 0, 0);
-    SetTextureFilter(textFont.texture, FILTER_BILINEAR);
-#else
-    textFont = LoadFontEx("resources/fonts/ClearSans-Bold.ttf", 124, 0, 0);
-    SetTextureFilter(textFont.texture, FILTER_BILINEAR);
+    asset->chars = calloc(FONT_CHARS, sizeof(CharInfo));
+
+    if (!asset->chars) return;
+
+    for (int i = 0; i < FONT_CHARS; i++)
+    {
+        const FontCacheGlyph *glyph = &cache->glyphs[i];
+
+        asset->chars[i] = (CharInfo){
+            .value    = glyph->value,
+            .rec      = { glyph->x, glyph->y, glyph->width, glyph->height },
+            .offsetX  = glyph->offsetX,
+            .offsetY  = glyph->offsetY,
+            .advanceX = glyph->advanceX
+        };
+    }
+
+    asset->atlas = (Image){
+        .data    = cache->pixels,
+        .width   = cache->width,
+        .height  = cache->height,
+        .mipmaps = 1,
+        .format  = cache->format
+    };
+
+    cache->pixels = NULL;    // Owned by the atlas now
+    asset->cached = true;
+}
+
+static int BakeFontCache(const Asset *asset, const FontCacheKey *key)
+{
+    FontCacheGlyph glyphs[FONT_CHARS];
+    const Image *atlas = &asset->atlas;
+
+    for (int i = 0; i < FONT_CHARS; i++)
+    {
+        const CharInfo *info = &asset->chars[i];
+
+        glyphs[i] = (FontCacheGlyph){
+            .value    = info->value,
+            .x        = (int)info->rec.x,
+            .y        = (int)info->rec.y,
+            .width    = (int)info->rec.width,
+            .height   = (int)info->rec.height,
+            .offsetX  = info->offsetX,
+            .offsetY  = info->offsetY,
+            .advanceX = info->advanceX
+        };
+    }
+
+    FontCache cache = {
+        .key        = *key,
+        .glyphs     = glyphs,
+        .pixels     = atlas->data,
+        .pixelBytes = (uint32_t)GetPixelDataSize(atlas->width, atlas->height, atlas->format),
+        .width      = atlas->width,
+        .height     = atlas->height,
+        .format     = atlas->format
+    };
+
+    return SaveFontCache(&cache, fontCachePath);
+}
+
+// Hand the decoded asset over to the GPU or to the audio device, the fallback stays if it failed
+static void UploadAsset(Asset *asset)
+{
+    double start = GetMonotonicTime();
+
+    if (asset->type == ASSET_SOUND && asset->wave.data)
+    {
+        *asset->sound = LoadSoundFromWave(asset->wave);
+        UnloadWave(asset->wave);
+
+        asset->wave     = (Wave){ 0 };
+        asset->uploaded = true;
+    }
+    else if (asset->type == ASSET_FONT && asset->atlas.data)
+    {
+        textFont = (Font){
+            .texture    = LoadTextureFromImage(asset->atlas),
+            .baseSize   = FONT_SIZE,
+            .charsCount = FONT_CHARS,
+            .chars      = asset->chars
+        };
+        SetTextureFilter(textFont.texture, FILTER_BILINEAR);
+        UnloadImage(asset->atlas);
+
+        asset->atlas    = (Image){ 0 };
+        asset->chars    = NULL;    // Owned by the font now
+        asset->uploaded = true;
+        stats.fontCached = asset->cached;
+
+        ClearTextLayouts();    // Measured with the default font
+    }
+    else
+    {
+        TraceLog(LOG_WARNING, "Asset %s can't be loaded", asset->path);
+        ReleaseAsset(asset);
+        stats.failed++;
+    }
+
+    double end = GetMonotonicTime();
+
+#ifdef DEBUG
+    RecordProfileZone(PROFILE_ASSET_UPLOAD, start, end);
 #endif
+
+    stats.decodeTime += asset->decodeTime;
+    stats.uploadTime += end - start;
+    asset->finished = true;
 }
 
-void UnloadFonts(void)
+static void ReleaseAsset(Asset *asset)
 {
-    UnloadFont(textFont);
+    if (asset->wave.data) UnloadWave(asset->wave);
+    if (asset->atlas.data) UnloadImage(asset->atlas);
+
+    if (asset->chars)
+    {
+        for (int i = 0; i < FONT_CHARS; i++) free(asset->chars[i].data);
+        free(asset->chars);
+    }
+
+    asset->wave  = (Wave){ 0 };
+    asset->atlas = (Image){ 0 };
+    asset->chars = NULL;
+}
+
+static void JoinLoaders(void)
+{
+    for (int type = 0; type < ASSET_TYPE_COUNT; type++)
+    {
+        if (loaders[type].started) pthread_join(loaders[type].thread, NULL);
+
+        loaders[type].started = false;
+    }
 }
@@ -1,9 +1,32 @@
 #ifndef RESOURCES_H
 #define RESOURCES_H
 
+#include <stdbool.h>
 #include <sys/param.h>  // PATH_MAX
 #include "raylib.h"
 
+/*
+ * The sounds and the font are read and decoded by loader threads while the
+ * window opens, UpdateResources() uploads each one on the main thread once it
+ * is ready. Until then the font is the raylib default one and the sounds are
+ * silent, so the first frame doesn't wait for the assets. The font atlas is
+ * baked into a cache next to the save on the first launch and read back
+ * from it on the next ones.
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    double queued;                 // Monotonic time the loads were started
+    double loaded;                 // Monotonic time the last asset was uploaded, 0 until then
+    double decodeTime;             // Seconds of reading and decoding, summed over the assets
+    double uploadTime;             // Seconds of the uploads on the main thread
+    int failed;                    // Assets that couldn't be loaded, their fallback stays
+    bool fontCached;               // The font atlas came from the baked cache
+    bool async;
+} ResourceStats;
+
 //-------------------------------------------------------------------------------------------------
 // Global Variable Declaration
 //-------------------------------------------------------------------------------------------------
@@ -20,11 +43,15 @@ extern Font textFont;
 // Save data
 extern char saveDirPath[PATH_MAX];
 extern char saveFilePath[PATH_MAX];
+extern char historyFilePath[PATH_MAX];
 
 //-------------------------------------------------------------------------------------------------
 // Functions Declaration
 //-------------------------------------------------------------------------------------------------
-void InitResources(const char *absolutepath);
+void InitResources(const char *absolutepath, bool async);
+bool UpdateResources(void);
 void UnloadResources(void);
+ResourceStats GetResourceStats(void);
+void PlaySFX(const Sound *sound);
 
 #endif  // RESOURCES_H
@@ -0,0 +1,187 @@
+#include "profiler.h"
+#include "saver.h"
+#include "timer.h"
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static void *SaverMain(void *arg);
+static int WriteRequest(Journal *journal, const SaveRequest *request);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+bool InitSaver(Saver *saver, Journal *journal)
+{
+    saver->journal = journal;
+    saver->count   = 0;
+    saver->busy    = false;
+    saver->stop    = false;
+    saver->stats   = (SaveStats){ 0 };
+
+    pthread_mutex_init(&saver->lock, NULL);
+    pthread_cond_init(&saver->wake, NULL);
+    pthread_cond_init(&saver->idle, NULL);
+
+    if (pthread_create(&saver->thread, NULL, SaverMain, saver) != 0)
+    {
+        saver->stop = true;    // Requests are written synchronously from now on
+        return false;
+    }
+
+    return true;
+}
+
+// Write everything pending and stop the I/O thread
+void UnloadSaver(Saver *saver)
+{
+    pthread_mutex_lock(&saver->lock);
+    bool running = !saver->stop;
+    saver->stop = true;
+    pthread_cond_broadcast(&saver->wake);
+    pthread_mutex_unlock(&saver->lock);
+
+    if (running) pthread_join(saver->thread, NULL);
+
+    pthread_cond_destroy(&saver->idle);
+    pthread_cond_destroy(&saver->wake);
+    pthread_mutex_destroy(&saver->lock);
+}
+
+/*
+ * Queue the request for the I/O thread, never waits for the disk. A full
+ * queue merges the request into the last queued one.
+ */
+void SubmitSave(Saver *saver, const SaveRequest *request)
+{
+    pthread_mutex_lock(&saver->lock);
+
+    saver->stats.queued++;
+
+    if (saver->stop)
+    {
+        // The I/O thread isn't running, write on the calling thread
+        if (WriteRequest(saver->journal, request) != 0) saver->stats.failed++;
+        saver->stats.written++;
+    }
+    else if (saver->count == SAVER_QUEUE_SIZE)
+    {
+        SaveRequest *last = &saver->queue[saver->count - 1];
+
+        if (last->type < request->type) last->type = request->type;
+        if (last->type == SAVE_MOVE) last->type = SAVE_SNAPSHOT;
+        last->state = request->state;
+
+        saver->stats.coalesced++;
+    }
+    else
+    {
+        saver->queue[saver->count++] = *request;
+        pthread_cond_signal(&saver->wake);
+    }
+
+    pthread_mutex_unlock(&saver->lock);
+}
+
+// Wait until all the submitted requests are written
+void FlushSaver(Saver *saver)
+{
+    pthread_mutex_lock(&saver->lock);
+
+    while (saver->count > 0 || saver->busy)
+    {
+        pthread_cond_wait(&saver->idle, &saver->lock);
+    }
+
+    pthread_mutex_unlock(&saver->lock);
+}
+
+SaveStats GetSaveStats(Saver *saver)
+{
+    pthread_mutex_lock(&saver->lock);
+    SaveStats stats = saver->stats;
+    pthread_mutex_unlock(&saver->lock);
+
+    return stats;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+/*
+ * Take all the pending requests at once. More than one request is written
+ * as a single snapshot of the latest state, a new game among them keeps the
+ * journal truncation.
+ */
+static void *SaverMain(void *arg)
+{
+    Saver *saver = arg;
+
+    pthread_mutex_lock(&saver->lock);
+
+    for (;;)
+    {
+        while (saver->count == 0 && !saver->stop)
+        {
+            pthread_cond_wait(&saver->wake, &saver->lock);
+        }
+
+        if (saver->count == 0) break;    // Stopped with nothing left to write
+
+        SaveRequest request = saver->queue[saver->count - 1];
+        double submitted = saver->queue[0].submitted;
+        int count = saver->count;
+
+        if (count > 1)
+        {
+            for (int i = 0; i < count - 1; i++)
+            {
+                if (saver->queue[i].type > request.type) request.type = saver->queue[i].type;
+            }
+
+            if (request.type == SAVE_MOVE) request.type = SAVE_SNAPSHOT;
+        }
+
+        saver->count = 0;
+        saver->busy  = true;
+        pthread_mutex_unlock(&saver->lock);
+
+        PROFILE_BEGIN(PROFILE_SAVE_WRITE);
+        int result = WriteRequest(saver->journal, &request);
+        PROFILE_END(PROFILE_SAVE_WRITE);
+        double latency = GetMonotonicTime() - submitted;
+
+        pthread_mutex_lock(&saver->lock);
+        saver->busy = false;
+        saver->stats.written++;
+        saver->stats.coalesced += count - 1;
+        if (result != 0) saver->stats.failed++;
+        if (latency > saver->stats.maxLatency) saver->stats.maxLatency = latency;
+
+        if (saver->count == 0) pthread_cond_broadcast(&saver->idle);
+    }
+
+    pthread_cond_broadcast(&saver->idle);
+    pthread_mutex_unlock(&saver->lock);
+
+    return NULL;
+}
+
+static int WriteRequest(Journal *journal, const SaveRequest *request)
+{
+    switch (request->type)
+    {
+    case SAVE_MOVE:
+        return AppendJournalMove(journal, request->move, &request->state);
+
+    case SAVE_SNAPSHOT:
+        return AppendJournalSnapshot(journal, &request->state);
+
+    case SAVE_START:
+        return StartJournal(journal, &request->state);
+
+    default:
+        return -1;
+    }
+}
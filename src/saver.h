@@ -0,0 +1,62 @@
+#ifndef SAVER_H
+#define SAVER_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "journal.h"
+
+/*
+ * Background persistence. The game thread submits the journal writes to a
+ * bounded queue and a dedicated I/O thread performs them, so a slow disk
+ * never stalls a frame. If several requests are pending when the I/O thread
+ * wakes up, or the queue is full, they are coalesced into a single snapshot
+ * of the latest state, the recovery starts from it anyway. The journal must
+ * not be touched by anyone else while the saver runs. FlushSaver() waits for
+ * the writes, call it before GetSaveStats() to get the final counters.
+ */
+
+#define SAVER_QUEUE_SIZE   16
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef enum { SAVE_MOVE, SAVE_SNAPSHOT, SAVE_START } SaveType;    // Ordered by the priority
+
+typedef struct {
+    SaveType type;
+    JournalMove move;              // Only for SAVE_MOVE
+    JournalSnapshot state;         // State after the request
+    double submitted;              // Monotonic time of the submission
+} SaveRequest;
+
+typedef struct {
+    unsigned long long queued;     // Requests submitted
+    unsigned long long coalesced;  // Requests merged into a later snapshot
+    unsigned long long written;    // Journal writes performed
+    unsigned long long failed;     // Journal writes that returned an error
+    double maxLatency;             // Worst time from the submission to the written data, seconds
+} SaveStats;
+
+typedef struct {
+    Journal *journal;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;           // Signaled when a request was submitted or the saver stops
+    pthread_cond_t idle;           // Signaled when the queue was drained
+    SaveRequest queue[SAVER_QUEUE_SIZE];
+    int count;
+    bool busy;                     // The I/O thread is writing
+    bool stop;
+    SaveStats stats;
+} Saver;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+bool InitSaver(Saver *saver, Journal *journal);
+void UnloadSaver(Saver *saver);
+void SubmitSave(Saver *saver, const SaveRequest *request);
+void FlushSaver(Saver *saver);
+SaveStats GetSaveStats(Saver *saver);
+
+#endif  // SAVER_H
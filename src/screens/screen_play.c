@@ -1,12 +1,13 @@
 #include <stdlib.h>
-#include <stdio.h>
 #include <string.h>
 #include "raylib.h"
 #include "screens.h"
-#include "../board.h"
-#include "../game.h"
+#include "../profiler.h"
+#include "../redraw.h"
 #include "../resources.h"
 #include "../shapes.h"
+#include "../solver.h"
+#include "../textcache.h"
 #include "../utils.h"
 
 #define COLOR_TEXT           (Color){ 249, 246, 242, 255 }
@@ -15,8 +16,7 @@
 #define COLOR_SCORE          (Color){ 204, 193, 181, 245 }
 #define COLOR_GAMEOVER_TEXT  (Color){ 119, 110, 102, 255 }
 
-#define SCORE_MAX_BUFFER_SIZE       12
-#define ANIMATION_GAME_OVER_FRAMES  120
+#define ANIMATION_GAME_OVER_TIME    1.0f    // Seconds
 
 //-------------------------------------------------------------------------------------------------
 // Local Variables Definition
@@ -27,33 +27,43 @@ static Rectangle bestRec;
 static Rectangle purposeRec;
 static Rectangle retryRec;
 static Rectangle boardRec;
-
-static unsigned int gameOverFrames;
+static BoardLayout boardLayout;
+
+// Every text the purpose line can show, nothing is formatted while drawing
+static const char *hintTexts[] = {
+    "Hint: move LEFT", "Hint: move RIGHT", "Hint: move UP", "Hint: move DOWN"
+};
+static const char *goalTexts[] = {
+    "Join the numbers and get to the 2048 tile!",
+    "Join the numbers and get to the 4096 tile!",
+    "Join the numbers and get to the 8192 tile!",
+    "Join the numbers and get to the 16384 tile!",
+    "Join the numbers and get to the 32768 tile!",
+    "Join the numbers and get to the 65536 tile!"
+};
 
 //-------------------------------------------------------------------------------------------------
 // Local Functions Declaration
 //-------------------------------------------------------------------------------------------------
-static void HandleInput(void);
+static void HandleInput(Game *game);
+static void PlayMoveSound(const Event *event, void *context);
 
-static void DrawTile(void);
-static void DrawScore(void);
-static void DrawBest(void);
-static void DrawRetry(void);
-static void DrawPurpose(void);
-static void DrawGameOver(void);
+static void DrawPanels(void);
+static void DrawPanelValues(const Game *game);
+static void DrawPanelLabels(void);
+static void DrawPurpose(const Game *game);
+static void DrawGameOver(const Game *game, float lag);
 
 //-------------------------------------------------------------------------------------------------
 // Functions Definition
 //-------------------------------------------------------------------------------------------------
-void InitGameplayScreen(void)
+void InitGameplayScreen(Game *game)
 {
     TraceLog(LOG_DEBUG, "Init gameplay screen");
 
     int width  = GetScreenWidth();
     int height = GetScreenHeight();
 
-    gameOverFrames = 0;
-
     tileRec    = (Rectangle){ width*0.08f, height*0.05f, width*0.26f, width*0.26f };
     scoreRec   = (Rectangle){ width*0.46f, height*0.05f, width*0.21f, height*0.085f };
     bestRec    = (Rectangle){ width*0.7f,  height*0.05f, width*0.21f, height*0.085f };
@@ -61,36 +71,71 @@ void InitGameplayScreen(void)
     purposeRec = (Rectangle){ width*0.08f, height*0.26f, width*0.84f, height*0.06f };
     boardRec   = (Rectangle){ width*0.08f, height*0.34f, width*0.84f, width*0.84f };
 
-    InitBoard(&boardRec);
+    InitBoard(&boardLayout, &boardRec, game->board.grid.size);
+
+    Subscribe(&game->events, EVENT_MASK(MOVE_EVENT), PlayMoveSound, NULL, false);
+
+    GameAssist *assist = &game->assist;
+    SolverConfig config = GetDefaultSolverConfig();
+    config.threads = 0;    // Search on every processor
+
+    assist->autoplay    = false;
+    assist->hintVisible = false;
+    assist->ready       = false;
+
+    // The solver searches the bitboard, the other sizes have no hints
+    if (game->board.grid.size == BITBOARD_SIZE)
+    {
+        assist->ready = InitSolver(&assist->solver, config);
+
+        if (!assist->ready)
+        {
+            TraceLog(LOG_WARNING, "Solver can't be initialized, hints are disabled");
+        }
+    }
 }
 
-void UpdateGameplayScreen(void)
+// Once per frame, handles the input
+void UpdateGameplayScreen(Game *game)
 {
-    HandleInput();
+    Board *board = &game->board;
+
+    HandleInput(game);
 
-    switch (GetGame()->state)
+    switch (game->state)
     {
     case GAME_PLAY:
 
         /*
-         * Update Board only on gameplay state.
+         * Move the board only on gameplay state. On autoplay the solver
+         * enters a move every time the board is ready for the input.
          */
 
-        HandleBoardInput(&GetGame()->board);
-        UpdateBoard(&GetGame()->board);
+        if (game->assist.autoplay && board->state == BOARD_STATE_NONE)
+        {
+            SolverResult result = FindBestMove(&game->assist.solver,
+                                               GridToBitboard(&board->grid));
+            MoveGame(game, result.move);
+            RequestRedraw();
+        }
+        else if (!game->assist.autoplay)
+        {
+            HandleGameInput(game);
+        }
+
+        // Keep drawing until the move and the animations are over
+        if (board->state != BOARD_STATE_NONE || board->animation != ANIMATION_NONE)
+        {
+            RequestRedraw();
+        }
         break;
 
     case GAME_OVER:
-
-        /*
-         * Update game over animation.
-         */
-
-        if (gameOverFrames < ANIMATION_GAME_OVER_FRAMES)
+        if (board->animation != ANIMATION_NONE || board->state != BOARD_STATE_NONE ||
+            game->overTime < ANIMATION_GAME_OVER_TIME)
         {
-            gameOverFrames += 2;
+            RequestRedraw();
         }
-
         break;
 
     case GAME_WIN:
@@ -102,33 +147,75 @@ void UpdateGameplayScreen(void)
     }
 }
 
-void DrawGameplayScreen(void)
+// Fixed step of GAME_STEP_TIME, runs the board logic and the animations
+void StepGameplayScreen(Game *game)
 {
-    ClearBackground(COLOR_SCREEN);
+    switch (game->state)
+    {
+    case GAME_PLAY:
+        UpdateBoard(&game->board);
+        break;
 
-    // Draw all screen elements
-    DrawTile();
-    DrawScore();
-    DrawBest();
-    DrawRetry();
-    DrawPurpose();
-    DrawBoard(&GetGame()->board);
+    case GAME_OVER:
+
+        /*
+         * The last move still animates when the game is over, the game
+         * over animation starts after it.
+         */
+
+        if (game->board.state != BOARD_STATE_NONE)
+        {
+            UpdateBoard(&game->board);
+        }
+        else
+        {
+            game->overTime = MIN(game->overTime + GAME_STEP_TIME, ANIMATION_GAME_OVER_TIME);
+        }
+        break;
 
-    if (GetGame()->state == GAME_OVER)
+    default:
+        break;
+    }
+}
+
+// The lag is the time since the last step, the animations are drawn that far ahead
+void DrawGameplayScreen(Game *game, float lag)
+{
+    ClearBackground(COLOR_SCREEN);
+
+    /*
+     * Draw all screen elements grouped by the texture: the rounded rectangles,
+     * the default font texts and the board background share the shapes
+     * texture, the tiles come from the atlas, the text font goes last.
+     */
+    DrawPanels();
+    DrawPanelValues(game);
+    DrawBoard(&boardLayout, &game->board, lag);
+    DrawPanelLabels();
+    DrawPurpose(game);
+
+    if (game->state == GAME_OVER)
     {
-        DrawGameOver();
+        DrawGameOver(game, lag);
     }
 }
 
-void UnloadGameplayScreen(void)
+void UnloadGameplayScreen(Game *game)
 {
     TraceLog(LOG_DEBUG, "Unload gameplay screen");
+
+    Unsubscribe(&game->events, PlayMoveSound, NULL);
+
+    if (game->assist.ready) UnloadSolver(&game->assist.solver);
+    game->assist.ready = false;
+
+    UnloadBoard(&boardLayout);
 }
 
 //-------------------------------------------------------------------------------------------------
 // Local Functions Definition
 //-------------------------------------------------------------------------------------------------
-static void HandleInput()
+static void HandleInput(Game *game)
 {
     if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
     {
@@ -137,141 +224,187 @@ static void HandleInput()
         if ((mousePos.x > retryRec.x && mousePos.x < retryRec.x + retryRec.width) &&
             (mousePos.y > retryRec.y && mousePos.y < retryRec.y + retryRec.height))
         {
-            gameOverFrames = 0;
-            NewGame();
-            PlaySound(actionSound);
+            NewGame(game);
+            PlaySFX(&actionSound);
         }
     }
 
-    if (GetGame()->state == GAME_OVER && IsKeyPressed(KEY_ENTER))
+    if (game->state == GAME_OVER && IsKeyPressed(KEY_ENTER))
+    {
+        NewGame(game);
+        PlaySFX(&actionSound);
+    }
+
+    // Take back the last move or apply it again, also from the game over
+    if ((game->state == GAME_PLAY || game->state == GAME_OVER) &&
+        ((IsKeyPressed(KEY_U) && UndoGame(game)) || (IsKeyPressed(KEY_R) && RedoGame(game))))
     {
-        gameOverFrames = 0;
-        NewGame();
-        PlaySound(actionSound);
+        PlaySFX(&actionSound);
+    }
+
+    GameAssist *assist = &game->assist;
+
+    if (!assist->ready || game->state != GAME_PLAY) return;
+
+    // Search the best move for the current board and show it instead of the purpose
+    if (IsKeyPressed(KEY_H))
+    {
+        Bitboard cells = GridToBitboard(&game->board.grid);
+        SolverResult result = FindBestMove(&assist->solver, cells);
+
+        TraceLog(LOG_DEBUG, "Hint %d: depth %d, %llu nodes, %.2f ms", result.move, result.depth,
+                 result.nodes, result.elapsed * 1000);
+
+        assist->hintVisible = result.move != MOVE_COUNT;
+        assist->hintMove    = result.move;
+        assist->hintBoard   = cells;
+    }
+
+    // Toggle autoplay mode
+    if (IsKeyPressed(KEY_A))
+    {
+        assist->autoplay = !assist->autoplay;
+        PlaySFX(&actionSound);
     }
 }
 
-static void DrawTile(void)
+// One sound for every move of the frame, the merging ones sound different
+static void PlayMoveSound(const Event *event, void *context)
 {
-    static const char *text = "2048";
+    PlaySFX(event->mergeCount ? &mergeSound : &moveSound);
+}
 
-    float font = tileRec.height * 0.35f;
-    Vector2 vector = (Vector2) {
-        tileRec.x + tileRec.width*0.5f - MeasureText(text, font)*0.5f,
-        tileRec.y + tileRec.height*0.5f - font*0.5f
-    };
+static void DrawPanels(void)
+{
     DrawRoundedRectangleRec(tileRec, tileRec.width*0.05, COLOR_TILE);
-    DrawText(text, vector.x, vector.y, font, COLOR_TEXT);
+    DrawRoundedRectangleRec(scoreRec, scoreRec.width*0.05f, COLOR_SCORE);
+    DrawRoundedRectangleRec(bestRec, bestRec.width*0.05f, COLOR_SCORE);
+    DrawRoundedRectangleRec(retryRec, retryRec.width*0.04f, COLOR_BUTTON);
 }
 
-static void DrawScore(void)
+// Texts of the default font, it shares the texture with the rounded rectangles
+static void DrawPanelValues(const Game *game)
 {
     float font;
     Vector2 vector;
-    char buffer[SCORE_MAX_BUFFER_SIZE];
-    static const char *text = "SCORE";
-
-    DrawRoundedRectangleRec(scoreRec, scoreRec.width*0.05f, COLOR_SCORE);  // Draw background
+    const TextLayout *layout;
 
-    // Draw text 'SCORE'
-    font = scoreRec.height * 0.35f;
+    // Draw tile '2048'
+    font = tileRec.height * 0.35f;
+    layout = GetTextLayout(NULL, font, "2048");
     vector = (Vector2) {
-        scoreRec.x + scoreRec.width*0.5f - MeasureTextEx(textFont, text, font, 0).x*0.5f,
-        scoreRec.y + scoreRec.height*0.1f
+        tileRec.x + tileRec.width*0.5f - layout->extent.x*0.5f,
+        tileRec.y + tileRec.height*0.5f - font*0.5f
     };
-    DrawTextEx(textFont, text, vector, font, 0, WHITE);
+    PROFILE_CALL(PROFILE_TEXT, DrawText(layout->text, vector.x, vector.y, font, COLOR_TEXT));
 
     // Draw score value
-    sprintf(buffer, "%d", GetGame()->score);
     font = scoreRec.height * 0.32f;
+    layout = GetNumberLayout(NULL, font, game->score);
     vector = (Vector2) {
-        scoreRec.x + scoreRec.width*0.5f - MeasureText(buffer, font)*0.5f,
+        scoreRec.x + scoreRec.width*0.5f - layout->extent.x*0.5f,
         scoreRec.y + scoreRec.height*0.9f - font
     };
-    DrawText(buffer, vector.x, vector.y, font, WHITE);
+    PROFILE_CALL(PROFILE_TEXT, DrawText(layout->text, vector.x, vector.y, font, WHITE));
+
+    // Draw best value
+    font = scoreRec.height * 0.32f;
+    layout = GetNumberLayout(NULL, font, game->best);
+    vector = (Vector2) {
+        bestRec.x + bestRec.width*0.5f - layout->extent.x*0.5f,
+        bestRec.y + bestRec.height*0.9f - font
+    };
+    PROFILE_CALL(PROFILE_TEXT, DrawText(layout->text, vector.x, vector.y, font, WHITE));
 }
 
-static void DrawBest(void)
+// Texts of the text font
+static void DrawPanelLabels(void)
 {
     float font;
     Vector2 vector;
-    char buffer[SCORE_MAX_BUFFER_SIZE];
-    static const char *text = "BEST";
+    const TextLayout *layout;
 
-    DrawRoundedRectangleRec(bestRec, bestRec.width*0.05f, COLOR_SCORE);  // Draw background
-
-    // Draw text 'BEST'
+    // Draw text 'SCORE'
     font = scoreRec.height * 0.35f;
+    layout = GetTextLayout(&textFont, font, "SCORE");
     vector = (Vector2) {
-        bestRec.x + bestRec.width*0.5f - MeasureTextEx(textFont, text, font, 0).x*0.5f,
-        bestRec.y + bestRec.height*0.1f
+        scoreRec.x + scoreRec.width*0.5f - layout->extent.x*0.5f,
+        scoreRec.y + scoreRec.height*0.1f
     };
-    DrawTextEx(textFont, text, vector, font, 0, WHITE);
+    PROFILE_CALL(PROFILE_TEXT, DrawTextEx(textFont, layout->text, vector, font, 0, WHITE));
 
-    // Draw best value
-    sprintf(buffer, "%d", GetGame()->best);
-    font = scoreRec.height * 0.32f;
+    // Draw text 'BEST'
+    layout = GetTextLayout(&textFont, font, "BEST");
     vector = (Vector2) {
-        bestRec.x + bestRec.width*0.5f - MeasureText(buffer, font)*0.5f,
-        bestRec.y + bestRec.height*0.9f - font
+        bestRec.x + bestRec.width*0.5f - layout->extent.x*0.5f,
+        bestRec.y + bestRec.height*0.1f
     };
-    DrawText(buffer, vector.x, vector.y, font, WHITE);
-}
-
-static void DrawRetry(void)
-{
-    static const char *text = "New Game";
+    PROFILE_CALL(PROFILE_TEXT, DrawTextEx(textFont, layout->text, vector, font, 0, WHITE));
 
-    float font = retryRec.height * 0.58f;
-    Vector2 vector = (Vector2) {
-        retryRec.x + retryRec.width*0.5f - MeasureTextEx(textFont, text, font, 0).x*0.5f,
+    // Draw retry button text
+    font = retryRec.height * 0.58f;
+    layout = GetTextLayout(&textFont, font, "New Game");
+    vector = (Vector2) {
+        retryRec.x + retryRec.width*0.5f - layout->extent.x*0.5f,
         retryRec.y + retryRec.height*0.5f - font*0.5f
     };
-    DrawRoundedRectangleRec(retryRec, retryRec.width*0.04f, COLOR_BUTTON);
-    DrawTextEx(textFont, text, vector, font, 0, COLOR_TEXT);
+    PROFILE_CALL(PROFILE_TEXT, DrawTextEx(textFont, layout->text, vector, font, 0, COLOR_TEXT));
 }
 
-static void DrawPurpose(void)
+static void DrawPurpose(const Game *game)
 {
-    char buffer[64];
-    static const char *text = "Join the numbers and get to the %d tile!";
-
+    const GameAssist *assist = &game->assist;
     float font = purposeRec.height * 0.64f;
     Vector2 vector = (Vector2) {
         purposeRec.x,
         purposeRec.y + purposeRec.height*0.5f - font*0.5f
     };
-    sprintf(buffer, text, 2 << (MAX(GetGame()->max, 10)));
-    DrawTextEx(textFont, buffer, vector, font, 0, LIGHTGRAY);
+    int goal = MIN(MAX((int)game->max, 10), 15);    // Exponent of the next tile to get to
+    const char *text = goalTexts[goal - 10];
+
+    if (assist->autoplay) text = "Autoplay, press A to take over";
+    else if (assist->hintVisible && assist->hintBoard == GridToBitboard(&game->board.grid))
+    {
+        text = hintTexts[assist->hintMove];
+    }
+
+    PROFILE_CALL(PROFILE_TEXT, DrawTextEx(textFont, text, vector, font, 0, LIGHTGRAY));
 }
 
-static void DrawGameOver(void)
+static void DrawGameOver(const Game *game, float lag)
 {
     float font;
     Vector2 vector;
-    static const char *text1 = "Game Over!";
-    static const char *text2 = "Press Enter to Try again";
+    const TextLayout *layout;
 
-    unsigned short alpha = gameOverFrames < 90 ? gameOverFrames * 2 : 180;
+    // The overlay fades in over the first 3/4 of the animation, the texts rise 120 pixels
+    float progress = MIN(game->overTime + lag, ANIMATION_GAME_OVER_TIME) /
+                     ANIMATION_GAME_OVER_TIME;
+    float rise = progress * 120;
+    unsigned char alpha = MIN(progress * 240, 180);
 
     DrawRoundedRectangleRec(boardRec, boardRec.width * 0.015, (Color){ 238, 228, 218, alpha });
 
-    if (gameOverFrames > 30)
+    if (progress > 0.25f)
     {
         // Draw text1
         font = boardRec.width * 0.2f;
+        layout = GetTextLayout(&textFont, font, "Game Over!");
         vector = (Vector2) {
-            boardRec.x + boardRec.width*0.5f - MeasureTextEx(textFont, text1, font, 0).x*0.5f,
-            boardRec.y + boardRec.height*0.65f - font*0.5f - gameOverFrames
+            boardRec.x + boardRec.width*0.5f - layout->extent.x*0.5f,
+            boardRec.y + boardRec.height*0.65f - font*0.5f - rise
         };
-        DrawTextEx(textFont, text1, vector, font, 0, COLOR_GAMEOVER_TEXT);
+        PROFILE_CALL(PROFILE_TEXT,
+                     DrawTextEx(textFont, layout->text, vector, font, 0, COLOR_GAMEOVER_TEXT));
 
         // Draw text2
         font = boardRec.width * 0.08f;
+        layout = GetTextLayout(&textFont, font, "Press Enter to Try again");
         vector = (Vector2) {
-            boardRec.x + boardRec.width*0.5f - MeasureTextEx(textFont, text2, font, 0).x*0.5f,
-            boardRec.y + boardRec.height*0.8f - font*0.5f - gameOverFrames
+            boardRec.x + boardRec.width*0.5f - layout->extent.x*0.5f,
+            boardRec.y + boardRec.height*0.8f - font*0.5f - rise
         };
-        DrawTextEx(textFont, text2, vector, font, 0, COLOR_GAMEOVER_TEXT);
+        PROFILE_CALL(PROFILE_TEXT,
+                     DrawTextEx(textFont, layout->text, vector, font, 0, COLOR_GAMEOVER_TEXT));
     }
 }
@@ -1,8 +1,9 @@
 #include "raylib.h"
 #include "screens.h"
-#include "../game.h"
+#include "../profiler.h"
 #include "../resources.h"
 #include "../shapes.h"
+#include "../textcache.h"
 
 #define COLOR_TEXT       (Color){ 119, 110, 102, 255 }
 #define COLOR_TILE       (Color){ 237, 194,  46, 255 }
@@ -38,19 +39,19 @@ void InitGameWinScreen(void)
     textRec  = (Rectangle){ width*0.08f, height*0.65f, width*0.84f, height*0.05f };
 }
 
-void UpdateGameWinScreen(void)
+void UpdateGameWinScreen(Game *game)
 {
     if (IsKeyPressed(KEY_ENTER))
     {
-        GetGame()->state = GAME_PLAY;
-        nextScreen       = SCREEN_PLAY;
+        game->state = GAME_PLAY;
+        nextScreen  = SCREEN_PLAY;
 
-        PlaySound(actionSound);
+        PlaySFX(&actionSound);
     }
 
     if (!appearSoundPlayed)
     {
-        PlaySound(appearSound);
+        PlaySFX(&appearSound);
         appearSoundPlayed = true;
     }
 }
@@ -59,33 +60,37 @@ void DrawGameWinScreen(void)
 {
     float font;
     Vector2 vector;
+    const TextLayout *layout;
 
     ClearBackground(COLOR_SCREEN);
 
     // Draw title
     font = titleRec.height * 0.78f;
+    layout = GetTextLayout(&textFont, font, titleText);
     vector = (Vector2) {
-        titleRec.x + titleRec.width*0.5f - MeasureTextEx(textFont, titleText, font, 0).x*0.5f,
+        titleRec.x + titleRec.width*0.5f - layout->extent.x*0.5f,
         titleRec.y + titleRec.height*0.5f - font*0.5f
     };
-    DrawTextEx(textFont, titleText, vector, font, 0, COLOR_TEXT);
+    PROFILE_CALL(PROFILE_TEXT, DrawTextEx(textFont, titleText, vector, font, 0, COLOR_TEXT));
 
     // Draw tile
     font = tileRec.height * 0.35f;
+    layout = GetTextLayout(NULL, font, tileText);
     vector = (Vector2) {
-        tileRec.x + tileRec.width*0.5f - MeasureText(tileText, font)*0.5f,
+        tileRec.x + tileRec.width*0.5f - layout->extent.x*0.5f,
         tileRec.y + tileRec.height*0.5f - font*0.5f
     };
     DrawRoundedRectangleRec(tileRec, tileRec.width*0.05f, COLOR_TILE);
-    DrawText(tileText, vector.x, vector.y, font, COLOR_TILE_TEXT);
+    PROFILE_CALL(PROFILE_TEXT, DrawText(tileText, vector.x, vector.y, font, COLOR_TILE_TEXT));
 
     // Draw help text
     font = textRec.height * 0.78f;
+    layout = GetTextLayout(&textFont, font, text);
     vector = (Vector2) {
-        textRec.x + textRec.width*0.5f - MeasureTextEx(textFont, text, font, 0).x*0.5f,
+        textRec.x + textRec.width*0.5f - layout->extent.x*0.5f,
         textRec.y + textRec.height*0.5f - font*0.5f
     };
-    DrawTextEx(textFont, text, vector, font, 0, COLOR_TEXT);
+    PROFILE_CALL(PROFILE_TEXT, DrawTextEx(textFont, text, vector, font, 0, COLOR_TEXT));
 }
 
 void UnloadGameWinScreen(void)
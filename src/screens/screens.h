@@ -1,6 +1,8 @@
 #ifndef SCREENS_H
 #define SCREENS_H
 
+#include "../game.h"
+
 #define COLOR_SCREEN  (Color){ 250, 248, 239, 255 }
 
 //-------------------------------------------------------------------------------------------------
@@ -17,16 +19,17 @@ GameScreen nextScreen;
 //-------------------------------------------------------------------------------------------------
 // Gameplay Screen Functions Declaration
 //-------------------------------------------------------------------------------------------------
-void InitGameplayScreen(void);
-void UpdateGameplayScreen(void);
-void DrawGameplayScreen(void);
-void UnloadGameplayScreen(void);
+void InitGameplayScreen(Game *game);
+void UpdateGameplayScreen(Game *game);
+void StepGameplayScreen(Game *game);
+void DrawGameplayScreen(Game *game, float lag);
+void UnloadGameplayScreen(Game *game);
 
 //-------------------------------------------------------------------------------------------------
 // Game Win Screen Functions Declaration
 //-------------------------------------------------------------------------------------------------
 void InitGameWinScreen(void);
-void UpdateGameWinScreen(void);
+void UpdateGameWinScreen(Game *game);
 void DrawGameWinScreen(void);
 void UnloadGameWinScreen(void);
 
@@ -1,4 +1,5 @@
-#include <math.h>  // Required for: sinf(), cosf()
+#include "geometry.h"
+#include "profiler.h"
 #include "shapes.h"
 
 //-------------------------------------------------------------------------------------------------
@@ -11,50 +12,67 @@ static Rectangle recTexShapes = {0};
 // Local Functions Declaration
 //-------------------------------------------------------------------------------------------------
 static Texture2D GetShapesTexture(void);
-static void DrawCirclePro(Vector2 center, float radius, Color color,
-                          int startAngleRadians, int endAngleRadians);
 
 //-------------------------------------------------------------------------------------------------
 // Functions Definition
 //-------------------------------------------------------------------------------------------------
+
+/*
+ * The whole rectangle is appended to the current batch at once with the
+ * shapes texture, so consecutive rounded rectangles share one draw call and
+ * the batch is checked for space once per rectangle. The corner segments
+ * follow the radius, see geometry.h.
+ */
 void DrawRoundedRectangleRec(Rectangle rec, float radius, Color color)
 {
-    Rectangle recMiddle, recLeft, recRight;
-
-    /* Make sure the rectangle is at least as wide and tall as
-     * the rounded corners.
-     */
-    if (rec.width < (radius * 2)) 
-        rec.width = radius * 2;
-
-    if (rec.height < (radius * 2)) 
-        rec.height = radius * 2;
-
-    recMiddle.x = rec.x + radius;
-    recMiddle.y = rec.y; 
-    recMiddle.width = rec.width - radius * 2;
-    recMiddle.height = rec.height;
-
-    /* Left rectangle */
-    recLeft.x = rec.x;
-    recLeft.y = rec.y + radius; 
-    recLeft.width = recMiddle.x - recLeft.x;
-    recLeft.height = rec.height - radius * 2;
-
-    /* Right rectangle */
-    recRight.x = recMiddle.x + recMiddle.width;
-    recRight.y = recLeft.y; 
-    recRight.width = recLeft.width;
-    recRight.height = recLeft.height; 
-
-    DrawCirclePro((Vector2){recMiddle.x, recLeft.y}, radius, color, 180, 270);                    // Draw Left-Up corner
-    DrawCirclePro((Vector2){recMiddle.x, recLeft.y + recLeft.height}, radius, color, 270, 360);   // Draw Left-Down corner
-    DrawCirclePro((Vector2){recMiddle.x + recMiddle.width, recRight.y}, radius, color, 90, 180);  // Draw Right-Up corner
-    DrawCirclePro((Vector2){recMiddle.x + recMiddle.width,
-                            recRight.y + recRight.height}, radius, color, 0, 90);                 // Draw Right-Down corner
-    DrawRectangleRec(recMiddle, color);  // Draw vertical rectangle
-    DrawRectangleRec(recLeft, color);    // Draw horizontal rectangle
-    DrawRectangleRec(recRight, color);   // Draw horizontal rectangle
+    PROFILE_BEGIN(PROFILE_ROUNDED_RECT);
+
+    GeometryVertex vertices[GEOMETRY_MAX_VERTICES];
+    int count = BuildRoundedRectangle(rec.x, rec.y, rec.width, rec.height, radius, vertices);
+
+#if defined(SUPPORT_QUADS_DRAW_MODE)
+    Texture2D texture = GetShapesTexture();
+
+    // Every vertex samples the same white texel
+    float u = (recTexShapes.x + recTexShapes.width*0.5f)/texture.width;
+    float v = (recTexShapes.y + recTexShapes.height*0.5f)/texture.height;
+
+    if (rlCheckBufferLimit(RL_QUADS, count)) rlglDraw();
+
+    rlEnableTexture(texture.id);
+
+    rlBegin(RL_QUADS);
+        rlColor4ub(color.r, color.g, color.b, color.a);
+
+        for (int i = 0; i < count; i++)
+        {
+            rlTexCoord2f(u, v);
+            rlVertex2f(vertices[i].x, vertices[i].y);
+        }
+    rlEnd();
+
+    rlDisableTexture();
+#else
+    if (rlCheckBufferLimit(RL_TRIANGLES, count/4*6)) rlglDraw();
+
+    rlBegin(RL_TRIANGLES);
+        rlColor4ub(color.r, color.g, color.b, color.a);
+
+        // Every quad is split into two triangles with the same winding
+        for (int i = 0; i < count; i += 4)
+        {
+            rlVertex2f(vertices[i].x, vertices[i].y);
+            rlVertex2f(vertices[i + 1].x, vertices[i + 1].y);
+            rlVertex2f(vertices[i + 2].x, vertices[i + 2].y);
+
+            rlVertex2f(vertices[i].x, vertices[i].y);
+            rlVertex2f(vertices[i + 2].x, vertices[i + 2].y);
+            rlVertex2f(vertices[i + 3].x, vertices[i + 3].y);
+        }
+    rlEnd();
+#endif
+
+    PROFILE_END(PROFILE_ROUNDED_RECT);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -76,55 +94,9 @@ static Texture2D GetShapesTexture(void)
         recTexShapes = (Rectangle){ rec.x + 1, rec.y + 1, rec.width - 2, rec.height - 2 };
 #else
         texShapes = GetTextureDefault();  // Use default white texture
-        recTexShapes = { 0.0f, 0.0f, 1.0f, 1.0f };
+        recTexShapes = (Rectangle){ 0.0f, 0.0f, 1.0f, 1.0f };
 #endif
     }
 
     return texShapes;
 }
-
-// Draw a color-filled circle (Vector version)
-// NOTE: On OpenGL 3.3 and ES2 we use QUADS to avoid drawing order issues (view rlglDraw)
-static void DrawCirclePro(Vector2 center, float radius, Color color,
-                          int startAngleRadians, int endAngleRadians)
-{
-#if defined(SUPPORT_QUADS_DRAW_MODE)
-    if (rlCheckBufferLimit(RL_QUADS, 4*(36/2))) rlglDraw();
-
-    rlEnableTexture(GetShapesTexture().id);
-
-    rlBegin(RL_QUADS);
-        for (int i = startAngleRadians; i <= endAngleRadians; i += 20)
-        {
-            rlColor4ub(color.r, color.g, color.b, color.a);
-
-            rlTexCoord2f(recTexShapes.x/texShapes.width, recTexShapes.y/texShapes.height);
-            rlVertex2f(center.x, center.y);
-
-            rlTexCoord2f(recTexShapes.x/texShapes.width, (recTexShapes.y + recTexShapes.height)/texShapes.height);
-            rlVertex2f(center.x + sinf(DEG2RAD*i)*radius, center.y + cosf(DEG2RAD*i)*radius);
-
-            rlTexCoord2f((recTexShapes.x + recTexShapes.width)/texShapes.width, (recTexShapes.y + recTexShapes.height)/texShapes.height);
-            rlVertex2f(center.x + sinf(DEG2RAD*(i + 10))*radius, center.y + cosf(DEG2RAD*(i + 10))*radius);
-
-            rlTexCoord2f((recTexShapes.x + recTexShapes.width)/texShapes.width, recTexShapes.y/texShapes.height);
-            rlVertex2f(center.x + sinf(DEG2RAD*(i + 20))*radius, center.y + cosf(DEG2RAD*(i + 20))*radius);
-        }
-    rlEnd();
-
-    rlDisableTexture();
-#else
-    if (rlCheckBufferLimit(RL_TRIANGLES, 3*(36/2))) rlglDraw();
-
-    rlBegin(RL_TRIANGLES);
-        for (int i = startAngleRadians; i <= endAngleRadians; i += 10)
-        {
-            rlColor4ub(color.r, color.g, color.b, color.a);
-
-            rlVertex2f(center.x, center.y);
-            rlVertex2f(center.x + sinf(DEG2RAD*i)*radius, center.y + cosf(DEG2RAD*i)*radius);
-            rlVertex2f(center.x + sinf(DEG2RAD*(i + 10))*radius, center.y + cosf(DEG2RAD*(i + 10))*radius);
-        }
-    rlEnd();
-#endif
-}
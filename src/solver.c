@@ -0,0 +1,427 @@
+#include <math.h>    // powf
+#include <stdlib.h>  // calloc, free
+#include <string.h>  // memcpy, memset
+#include "solver.h"
+#include "timer.h"
+
+#define ROW_COUNT            65536
+#define DEADLINE_CHECK_MASK  0xFFF    // Check the clock every 4096 nodes
+
+// Heuristic weights, tuned for the corner strategy
+#define SCORE_LOST_PENALTY        200000.0f
+#define SCORE_MONOTONICITY_POWER  4.0f
+#define SCORE_MONOTONICITY_WEIGHT 47.0f
+#define SCORE_SUM_POWER           3.5f
+#define SCORE_SUM_WEIGHT          11.0f
+#define SCORE_MERGES_WEIGHT       700.0f
+#define SCORE_EMPTY_WEIGHT        270.0f
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static float heuristicTable[ROW_COUNT];    // Static evaluation of every possible row
+static bool heuristicReady = false;
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static void InitHeuristicTable(void);
+static Direction SearchRoot(Solver *solver, Bitboard board, int depth, float *value);
+static void RunRootTask(void *arg, int worker);
+static float SearchMove(SearchContext *context, Bitboard board, int depth, float probability);
+static float SearchChance(SearchContext *context, Bitboard board, int depth, float probability);
+static inline bool IsAborted(Solver *solver);
+static inline TableEntry *GetTableEntry(Solver *solver, Bitboard board);
+static inline bool LoadTableEntry(TableEntry *entry, Bitboard board, int depth, float *value);
+static inline void StoreTableEntry(TableEntry *entry, Bitboard board, int depth, float value);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+SolverConfig GetDefaultSolverConfig(void)
+{
+    return (SolverConfig){
+        .maxDepth          = SOLVER_DEFAULT_DEPTH,
+        .timeBudget        = SOLVER_DEFAULT_TIME,
+        .probabilityCutoff = SOLVER_DEFAULT_CUTOFF,
+        .tableBits         = SOLVER_DEFAULT_TABLE_BITS,
+        .threads           = SOLVER_DEFAULT_THREADS,
+    };
+}
+
+bool InitSolver(Solver *solver, SolverConfig config)
+{
+    InitMoveTables();
+    InitHeuristicTable();
+
+    if (config.maxDepth < 1) config.maxDepth = 1;
+    if (config.tableBits < 1) config.tableBits = SOLVER_DEFAULT_TABLE_BITS;
+    if (config.threads < 1) config.threads = GetProcessorCount();
+
+    solver->config    = config;
+    solver->tableMask = (1u << config.tableBits) - 1;
+    solver->table     = calloc(solver->tableMask + 1, sizeof(TableEntry));
+    solver->aborted   = false;
+    solver->contexts  = NULL;
+
+    if (!solver->table) return false;
+
+    if (!InitThreadPool(&solver->pool, config.threads))
+    {
+        free(solver->table);
+        solver->table = NULL;
+        return false;
+    }
+
+    solver->config.threads = solver->pool.count;    // Threads actually started
+    solver->contexts = calloc(solver->pool.count, sizeof(SearchContext));
+
+    if (!solver->contexts)
+    {
+        UnloadSolver(solver);
+        return false;
+    }
+
+    for (int i = 0; i < solver->pool.count; i++)
+    {
+        solver->contexts[i].solver = solver;
+    }
+
+    return true;
+}
+
+void UnloadSolver(Solver *solver)
+{
+    if (!solver->table) return;
+
+    UnloadThreadPool(&solver->pool);
+
+    free(solver->contexts);
+    free(solver->table);
+    solver->contexts = NULL;
+    solver->table    = NULL;
+}
+
+void ClearSolverTable(Solver *solver)
+{
+    memset(solver->table, 0, sizeof(TableEntry) * (solver->tableMask + 1));
+}
+
+/*
+ * Deepen the search one player move at a time. The iteration interrupted by
+ * the deadline is thrown away, the result of the last completed one is used.
+ * The first iteration always completes so there is a move even on a tiny
+ * time budget.
+ */
+SolverResult FindBestMove(Solver *solver, Bitboard board)
+{
+    double start = GetMonotonicTime();
+    SolverResult result = { MOVE_COUNT, 0.0f, 0, 0, 0.0 };
+
+    solver->aborted  = false;
+    solver->deadline = 0.0;
+
+    for (int i = 0; i < solver->pool.count; i++)
+    {
+        solver->contexts[i].nodes = 0;
+    }
+
+    for (int depth = 1; depth <= solver->config.maxDepth; depth++)
+    {
+        float value;
+
+        // Never interrupt the first iteration
+        if (depth > 1 && solver->config.timeBudget > 0)
+            solver->deadline = start + solver->config.timeBudget;
+
+        Direction best = SearchRoot(solver, board, depth, &value);
+
+        if (IsAborted(solver)) break;
+
+        result.move  = best;
+        result.value = value;
+        result.depth = depth;
+
+        if (best == MOVE_COUNT) break;
+        if (solver->config.timeBudget > 0 &&
+            GetMonotonicTime() - start >= solver->config.timeBudget) break;
+    }
+
+    for (int i = 0; i < solver->pool.count; i++)
+    {
+        result.nodes += solver->contexts[i].nodes;
+    }
+
+    result.elapsed = GetMonotonicTime() - start;
+
+    return result;
+}
+
+// Static evaluation of the board, the sum of its rows and columns
+float EvaluateBoard(Bitboard board)
+{
+    Bitboard transposed = Transpose(board);
+    float value = 0.0f;
+
+    for (int i = 0; i < BITBOARD_SIZE; i++)
+    {
+        value += heuristicTable[(board >> (16 * i)) & 0xFFFF];
+        value += heuristicTable[(transposed >> (16 * i)) & 0xFFFF];
+    }
+    return value;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+/*
+ * The row is rewarded for empty cells and equal neighbours and penalized for
+ * the non monotonic order and for the sum of its tiles raised to
+ * SCORE_SUM_POWER, so a few big tiles score better than many medium ones.
+ * A row doesn't know where it sits on the grid, no term depends on that.
+ */
+static void InitHeuristicTable(void)
+{
+    if (heuristicReady) return;
+
+    for (unsigned int row = 0; row < ROW_COUNT; row++)
+    {
+        unsigned int line[BITBOARD_SIZE];
+        float sum = 0.0f;
+        int empty = 0, merges = 0, counter = 0;
+        unsigned int prev = 0;
+
+        for (int i = 0; i < BITBOARD_SIZE; i++)
+        {
+            line[i] = (row >> (4 * i)) & 0xF;
+            sum += powf((float)line[i], SCORE_SUM_POWER);
+
+            if (line[i] == 0)
+            {
+                empty++;
+            }
+            else
+            {
+                if (prev == line[i]) counter++;
+                else if (counter > 0)
+                {
+                    merges += 1 + counter;
+                    counter = 0;
+                }
+                prev = line[i];
+            }
+        }
+
+        if (counter > 0) merges += 1 + counter;
+
+        float monoLeft = 0.0f, monoRight = 0.0f;
+
+        for (int i = 1; i < BITBOARD_SIZE; i++)
+        {
+            float a = powf((float)line[i - 1], SCORE_MONOTONICITY_POWER);
+            float b = powf((float)line[i], SCORE_MONOTONICITY_POWER);
+
+            if (line[i - 1] > line[i]) monoLeft += a - b;
+            else monoRight += b - a;
+        }
+
+        heuristicTable[row] = SCORE_LOST_PENALTY +
+                              SCORE_EMPTY_WEIGHT * empty +
+                              SCORE_MERGES_WEIGHT * merges -
+                              SCORE_MONOTONICITY_WEIGHT * fminf(monoLeft, monoRight) -
+                              SCORE_SUM_WEIGHT * sum;
+    }
+
+    heuristicReady = true;
+}
+
+/*
+ * Search the root moves. On a single thread it is a plain max node, otherwise
+ * every (move, empty cell, spawned value) triple of the first chance layer is
+ * a pool task and the move values are assembled from the task results.
+ */
+static Direction SearchRoot(Solver *solver, Bitboard board, int depth, float *value)
+{
+    Direction best = MOVE_COUNT;
+    float values[MOVE_COUNT];
+    int empty[MOVE_COUNT];
+    int first[MOVE_COUNT + 1];
+    int count = 0;
+
+    *value = 0.0f;
+
+    for (int d = 0; d < MOVE_COUNT; d++)
+    {
+        unsigned int score;
+        Bitboard moved = ExecuteMove(board, d, &score);
+
+        first[d] = count;
+        empty[d] = 0;
+
+        if (moved == board) continue;
+
+        if (solver->pool.count == 1)
+        {
+            values[d] = SearchChance(&solver->contexts[0], moved, depth, 1.0f);
+            empty[d]  = 1;
+            continue;
+        }
+
+        empty[d] = CountEmptyCells(moved);
+
+        for (int i = 0; i < BITBOARD_CELLS; i++)
+        {
+            if (GetCell(moved, i)) continue;
+
+            for (unsigned int tile = 1; tile <= 2; tile++)
+            {
+                RootTask *task = &solver->tasks[count];
+
+                task->solver      = solver;
+                task->board       = SetCell(moved, i, tile);
+                task->depth       = depth - 1;
+                task->probability = (tile == 1 ? 0.9f : 0.1f) / empty[d];
+                task->value       = 0.0f;
+
+                SubmitTask(&solver->pool, count++, RunRootTask, task);
+            }
+        }
+    }
+    first[MOVE_COUNT] = count;
+
+    if (count) WaitThreadPool(&solver->pool);
+
+    for (int d = 0; d < MOVE_COUNT; d++)
+    {
+        if (!empty[d]) continue;
+
+        if (first[d] != first[d + 1])
+        {
+            float sum = 0.0f;
+
+            for (int t = first[d]; t < first[d + 1]; t++)
+            {
+                sum += solver->tasks[t].probability * solver->tasks[t].value;
+            }
+            values[d] = sum;
+        }
+
+        if (best == MOVE_COUNT || values[d] > *value)
+        {
+            best   = d;
+            *value = values[d];
+        }
+    }
+
+    return best;
+}
+
+static void RunRootTask(void *arg, int worker)
+{
+    RootTask *task = arg;
+
+    task->value = SearchMove(&task->solver->contexts[worker], task->board, task->depth,
+                             task->probability);
+}
+
+// Max node: the player picks the best move, a stuck board scores zero
+static float SearchMove(SearchContext *context, Bitboard board, int depth, float probability)
+{
+    float best = 0.0f;
+
+    for (int d = 0; d < MOVE_COUNT; d++)
+    {
+        unsigned int score;
+        Bitboard moved = ExecuteMove(board, d, &score);
+
+        if (moved == board) continue;
+
+        float value = SearchChance(context, moved, depth, probability);
+        if (value > best) best = value;
+    }
+    return best;
+}
+
+// Chance node: average over every empty cell getting a 2 (90%) or a 4 (10%)
+static float SearchChance(SearchContext *context, Bitboard board, int depth, float probability)
+{
+    Solver *solver = context->solver;
+    float value;
+
+    if (IsAborted(solver)) return 0.0f;
+
+    if ((++context->nodes & DEADLINE_CHECK_MASK) == 0 && solver->deadline > 0 &&
+        GetMonotonicTime() > solver->deadline)
+    {
+        __atomic_store_n(&solver->aborted, true, __ATOMIC_RELAXED);
+        return 0.0f;
+    }
+
+    if (depth <= 0 || probability < solver->config.probabilityCutoff)
+        return EvaluateBoard(board);
+
+    TableEntry *entry = GetTableEntry(solver, board);
+
+    if (LoadTableEntry(entry, board, depth, &value)) return value;
+
+    int empty = CountEmptyCells(board);
+    float cellProbability = probability / empty;
+    float sum = 0.0f;
+
+    for (int i = 0; i < BITBOARD_CELLS; i++)
+    {
+        if (GetCell(board, i)) continue;
+
+        sum += 0.9f * SearchMove(context, SetCell(board, i, 1), depth - 1, cellProbability * 0.9f);
+        sum += 0.1f * SearchMove(context, SetCell(board, i, 2), depth - 1, cellProbability * 0.1f);
+    }
+
+    value = sum / empty;
+
+    // Partial results of the interrupted search must not be cached
+    if (!IsAborted(solver)) StoreTableEntry(entry, board, depth, value);
+
+    return value;
+}
+
+static inline bool IsAborted(Solver *solver)
+{
+    return __atomic_load_n(&solver->aborted, __ATOMIC_RELAXED);
+}
+
+static inline TableEntry *GetTableEntry(Solver *solver, Bitboard board)
+{
+    // Fibonacci hashing spreads the similar boards over the table
+    uint64_t hash = (board * 0x9E3779B97F4A7C15ULL) >> 32;
+
+    return &solver->table[hash & solver->tableMask];
+}
+
+/*
+ * The entry words are read and written without locks. A pair of words from
+ * two different writes doesn't pass the check, so it is a plain table miss.
+ */
+static inline bool LoadTableEntry(TableEntry *entry, Bitboard board, int depth, float *value)
+{
+    uint64_t data  = __atomic_load_n(&entry->data, __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&entry->check, __ATOMIC_RELAXED);
+    uint32_t bits  = (uint32_t)data;
+
+    if ((check ^ data) != board || (int)(data >> 32) < depth) return false;
+
+    memcpy(value, &bits, sizeof(float));
+    return true;
+}
+
+static inline void StoreTableEntry(TableEntry *entry, Bitboard board, int depth, float value)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(float));
+
+    uint64_t data = ((uint64_t)depth << 32) | bits;
+
+    __atomic_store_n(&entry->check, board ^ data, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->data, data, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,89 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdbool.h>
+#include "bitboard.h"
+#include "threadpool.h"
+
+/*
+ * Depth-limited expectimax search over the player moves and the 2/4 spawn
+ * chance nodes. Chance nodes are cached in a hashed transposition table and
+ * spawn chains less likely than the probability cutoff are evaluated with the
+ * static heuristic. The search deepens iteratively until the depth or the
+ * time budget is exhausted. This module must not depend on raylib.
+ *
+ * With more than one thread the root moves and the first chance layer are
+ * split into tasks of the work-stealing pool, all the workers share one
+ * lockless transposition table.
+ */
+
+#define SOLVER_DEFAULT_DEPTH        8
+#define SOLVER_DEFAULT_TIME         0.008    // Seconds, fits a 16 ms frame
+#define SOLVER_DEFAULT_CUTOFF       0.0001f
+#define SOLVER_DEFAULT_TABLE_BITS   18       // 2^18 entries, 4 MB
+#define SOLVER_DEFAULT_THREADS      1
+
+#define SOLVER_MAX_ROOT_TASKS  (MOVE_COUNT * BITBOARD_CELLS * 2)
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    int maxDepth;              // Maximum search depth in player moves
+    double timeBudget;         // Search time limit in seconds, 0 - depth limit only
+    float probabilityCutoff;   // Less likely spawn chains are evaluated statically
+    int tableBits;             // Transposition table holds 2^tableBits entries
+    int threads;               // Search threads, 0 - one per processor
+} SolverConfig;
+
+// Entry is valid if check ^ data equals the board, so a torn concurrent write is a miss
+typedef struct {
+    uint64_t check;
+    uint64_t data;             // Depth in the high half, value bits in the low half
+} TableEntry;
+
+struct Solver;
+
+typedef struct {
+    struct Solver *solver;
+    unsigned long long nodes;
+} SearchContext;
+
+typedef struct {
+    struct Solver *solver;
+    Bitboard board;            // Board after the root move and the spawn
+    int depth;
+    float probability;
+    float value;
+} RootTask;
+
+typedef struct Solver {
+    SolverConfig config;
+    TableEntry *table;
+    unsigned int tableMask;
+    double deadline;           // Monotonic time the running search must stop at
+    bool aborted;              // Set if the running search hit the deadline
+    ThreadPool pool;
+    SearchContext *contexts;   // One per worker
+    RootTask tasks[SOLVER_MAX_ROOT_TASKS];
+} Solver;
+
+typedef struct {
+    Direction move;            // MOVE_COUNT if no move is available
+    float value;               // Expected heuristic value of the move
+    int depth;                 // Deepest completed iteration
+    unsigned long long nodes;
+    double elapsed;            // Seconds
+} SolverResult;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+SolverConfig GetDefaultSolverConfig(void);
+bool InitSolver(Solver *solver, SolverConfig config);
+void UnloadSolver(Solver *solver);
+void ClearSolverTable(Solver *solver);
+SolverResult FindBestMove(Solver *solver, Bitboard board);
+float EvaluateBoard(Bitboard board);
+
+#endif  // SOLVER_H
@@ -0,0 +1,145 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>   // snprintf
+#include <string.h>  // strcmp, strlen, memcpy
+#include "textcache.h"
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    TextLayout layout;
+    char text[TEXT_LAYOUT_SIZE];    // Copy of the string, the layout points to it
+    bool used;
+    bool number;             // Keyed by the value instead of the string
+    unsigned int value;
+    unsigned int font;       // Texture id + 1 of the font, 0 for the default font
+    float size;
+} TextLayoutEntry;
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static TextLayoutEntry entries[TEXT_LAYOUT_CAPACITY];
+static unsigned int count;
+
+static TextLayout uncached;      // Strings too long for the cache
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static TextLayoutEntry * FindEntry(bool number, unsigned int value, const char *text,
+                                   unsigned int font, float size, uint32_t hash);
+static void MeasureLayout(TextLayout *layout, const Font *font, float size);
+static uint32_t HashKey(uint32_t hash, unsigned int font, float size);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+const TextLayout * GetTextLayout(const Font *font, float size, const char *text)
+{
+    size_t length = strlen(text);
+    uint32_t hash = 2166136261u;    // FNV-1a
+
+    if (!font) size = (int)size;    // DrawText() truncates the size anyway
+
+    if (length >= TEXT_LAYOUT_SIZE)
+    {
+        uncached.text = text;
+        MeasureLayout(&uncached, font, size);
+        return &uncached;
+    }
+
+    for (size_t i = 0; i < length; i++) hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+
+    unsigned int key = font ? font->texture.id + 1 : 0;
+    TextLayoutEntry *entry = FindEntry(false, 0, text, key, size, HashKey(hash, key, size));
+
+    if (!entry->used)
+    {
+        *entry = (TextLayoutEntry){ .used = true, .font = key, .size = size };
+        memcpy(entry->text, text, length + 1);
+        entry->layout.text = entry->text;
+        MeasureLayout(&entry->layout, font, size);
+        count++;
+    }
+
+    return &entry->layout;
+}
+
+// Same as the layout of the decimal number, without formatting it on a hit
+const TextLayout * GetNumberLayout(const Font *font, float size, unsigned int value)
+{
+    if (!font) size = (int)size;
+
+    unsigned int key = font ? font->texture.id + 1 : 0;
+    TextLayoutEntry *entry = FindEntry(true, value, NULL, key, size,
+                                       HashKey(value * 2654435761u, key, size));
+
+    if (!entry->used)
+    {
+        *entry = (TextLayoutEntry){ .used = true, .number = true, .value = value, .font = key,
+                                    .size = size };
+        snprintf(entry->text, sizeof(entry->text), "%u", value);
+        entry->layout.text = entry->text;
+        MeasureLayout(&entry->layout, font, size);
+        count++;
+    }
+
+    return &entry->layout;
+}
+
+// Drop every layout, call it when the screen layout or a font changes
+void ClearTextLayouts(void)
+{
+    for (int i = 0; i < TEXT_LAYOUT_CAPACITY; i++) entries[i].used = false;
+
+    count = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+/*
+ * Open addressing with linear probing. Returns the matching entry or the free
+ * one the key belongs to, a full enough table is cleared first.
+ */
+static TextLayoutEntry * FindEntry(bool number, unsigned int value, const char *text,
+                                   unsigned int font, float size, uint32_t hash)
+{
+    if (count >= TEXT_LAYOUT_CAPACITY*3/4) ClearTextLayouts();
+
+    for (unsigned int i = hash % TEXT_LAYOUT_CAPACITY;; i = (i + 1) % TEXT_LAYOUT_CAPACITY)
+    {
+        TextLayoutEntry *entry = &entries[i];
+
+        if (!entry->used) return entry;
+
+        if (entry->number == number && entry->font == font && entry->size == size &&
+            (number ? entry->value == value : strcmp(entry->text, text) == 0))
+        {
+            return entry;
+        }
+    }
+}
+
+static void MeasureLayout(TextLayout *layout, const Font *font, float size)
+{
+    if (font)
+    {
+        layout->extent = MeasureTextEx(*font, layout->text, size, 0);
+    }
+    else
+    {
+        layout->extent = (Vector2){ MeasureText(layout->text, size), size };
+    }
+}
+
+static uint32_t HashKey(uint32_t hash, unsigned int font, float size)
+{
+    hash ^= font * 0x9e3779b9u;
+    hash ^= (uint32_t)(size * 64) * 0x85ebca6bu;
+
+    return hash ^ (hash >> 16);
+}
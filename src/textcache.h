@@ -0,0 +1,35 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include "raylib.h"
+
+/*
+ * Cache of the formatted and measured strings the screens draw every frame.
+ * A layout is keyed by the string or the number, the font and the size, so
+ * a changed score or tile value simply looks up another entry, only a layout
+ * change has to clear the cache. A NULL font is the default font of
+ * DrawText(), the other fonts are measured with no spacing like the screens
+ * draw them. The returned layout is valid until the next lookup. A string
+ * too long for the cache is measured on every lookup, its layout points to
+ * the caller's string.
+ */
+
+#define TEXT_LAYOUT_SIZE      48     // Longest cached string with the terminator
+#define TEXT_LAYOUT_CAPACITY  256    // Entries, the cache is cleared when it gets 3/4 full
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    const char *text;        // The cached copy of the string or the caller's one
+    Vector2 extent;          // Measured size of the text
+} TextLayout;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+const TextLayout * GetTextLayout(const Font *font, float size, const char *text);
+const TextLayout * GetNumberLayout(const Font *font, float size, unsigned int value);
+void ClearTextLayouts(void);
+
+#endif  // TEXTCACHE_H
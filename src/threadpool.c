@@ -0,0 +1,271 @@
+#if defined(_WIN32)
+#include <windows.h>  // GetSystemInfo
+#else
+#include <unistd.h>   // sysconf
+#endif
+
+#include <stdlib.h>   // malloc, calloc, free
+#include "threadpool.h"
+
+#define QUEUE_INITIAL_CAPACITY  64
+
+//-------------------------------------------------------------------------------------------------
+// Local Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+    ThreadPool *pool;
+    int index;
+} WorkerArgs;
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static void *WorkerMain(void *arg);
+static bool TakeTask(ThreadPool *pool, int worker, Task *task);
+static void RunTask(ThreadPool *pool, int worker, Task *task);
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+int GetProcessorCount(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+bool InitThreadPool(ThreadPool *pool, int workers)
+{
+    if (workers < 1) workers = 1;
+
+    pool->count   = workers;
+    pool->queued  = 0;
+    pool->pending = 0;
+    pool->stop    = false;
+    pool->queues  = calloc(workers, sizeof(WorkQueue));
+    pool->threads = calloc(workers, sizeof(pthread_t));
+
+    if (!pool->queues || !pool->threads)
+    {
+        free(pool->queues);
+        free(pool->threads);
+        return false;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (int i = 0; i < workers; i++)
+    {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+    }
+
+    // The worker 0 is the thread waiting for the pool
+    for (int i = 1; i < workers; i++)
+    {
+        WorkerArgs *args = malloc(sizeof(WorkerArgs));
+
+        if (args)
+        {
+            args->pool  = pool;
+            args->index = i;
+        }
+
+        if (!args || pthread_create(&pool->threads[i], NULL, WorkerMain, args) != 0)
+        {
+            free(args);
+
+            // Run with the workers started so far, the queues of the others are never used
+            for (int j = i; j < workers; j++) pthread_mutex_destroy(&pool->queues[j].lock);
+
+            pool->count = i;
+            break;
+        }
+    }
+
+    return true;
+}
+
+void UnloadThreadPool(ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->count; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    for (int i = 0; i < pool->count; i++)
+    {
+        pthread_mutex_destroy(&pool->queues[i].lock);
+        free(pool->queues[i].tasks);
+    }
+
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+
+    free(pool->queues);
+    free(pool->threads);
+    pool->queues  = NULL;
+    pool->threads = NULL;
+}
+
+/*
+ * Put the task into the worker deque. The workers aren't woken up until
+ * WaitThreadPool() is called, so a batch of tasks is distributed first.
+ */
+void SubmitTask(ThreadPool *pool, int worker, TaskFunction function, void *arg)
+{
+    WorkQueue *queue = &pool->queues[worker % pool->count];
+
+    // Count the task before it becomes visible, so the counters never go below zero
+    __atomic_add_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->count == queue->capacity)
+    {
+        int capacity = queue->capacity ? queue->capacity * 2 : QUEUE_INITIAL_CAPACITY;
+        Task *tasks  = malloc(sizeof(Task) * capacity);
+
+        // Out of memory, run the task right away instead of queueing it
+        if (!tasks)
+        {
+            pthread_mutex_unlock(&queue->lock);
+            __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+            __atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
+            function(arg, 0);
+            return;
+        }
+
+        // Unroll the circular buffer into the new storage
+        for (int i = 0; i < queue->count; i++)
+        {
+            tasks[i] = queue->tasks[(queue->head + i) % queue->capacity];
+        }
+
+        free(queue->tasks);
+        queue->tasks    = tasks;
+        queue->head     = 0;
+        queue->capacity = capacity;
+    }
+
+    queue->tasks[(queue->head + queue->count) % queue->capacity] = (Task){ function, arg };
+    queue->count++;
+
+    pthread_mutex_unlock(&queue->lock);
+}
+
+// Wake the workers up and run the tasks on the calling thread until all of them are finished
+void WaitThreadPool(ThreadPool *pool)
+{
+    Task task;
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    while (TakeTask(pool, 0, &task))
+    {
+        RunTask(pool, 0, &task);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    while (__atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) > 0)
+    {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+static void *WorkerMain(void *arg)
+{
+    WorkerArgs args = *(WorkerArgs *)arg;
+    ThreadPool *pool = args.pool;
+    Task task;
+
+    free(arg);
+
+    for (;;)
+    {
+        if (TakeTask(pool, args.index, &task))
+        {
+            RunTask(pool, args.index, &task);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->stop && __atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0)
+        {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        bool stop = pool->stop;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (stop) break;
+    }
+
+    return NULL;
+}
+
+// Pop the newest own task or steal the oldest task of another worker
+static bool TakeTask(ThreadPool *pool, int worker, Task *task)
+{
+    for (int i = 0; i < pool->count; i++)
+    {
+        WorkQueue *queue = &pool->queues[(worker + i) % pool->count];
+        bool taken = false;
+
+        pthread_mutex_lock(&queue->lock);
+
+        if (queue->count > 0)
+        {
+            if (i == 0) *task = queue->tasks[(queue->head + queue->count - 1) % queue->capacity];
+            else
+            {
+                *task = queue->tasks[queue->head];
+                queue->head = (queue->head + 1) % queue->capacity;
+            }
+
+            queue->count--;
+            taken = true;
+        }
+
+        pthread_mutex_unlock(&queue->lock);
+
+        if (taken)
+        {
+            __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void RunTask(ThreadPool *pool, int worker, Task *task)
+{
+    task->function(task->arg, worker);
+
+    if (__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST) == 0)
+    {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->idle);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/*
+ * Work-stealing thread pool. Every worker owns a task deque, it takes the
+ * newest task from its own deque and steals the oldest one from the others
+ * when it runs out of work. The thread calling WaitThreadPool() works as the
+ * worker 0, so a pool of N workers starts N - 1 threads.
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef void (*TaskFunction)(void *arg, int worker);
+
+typedef struct {
+    TaskFunction function;
+    void *arg;
+} Task;
+
+typedef struct {
+    pthread_mutex_t lock;
+    Task *tasks;             // Circular buffer, owner pops the tail, thieves pop the head
+    int head;
+    int count;
+    int capacity;
+} WorkQueue;
+
+typedef struct {
+    int count;               // Number of workers including the waiting thread
+    pthread_t *threads;
+    WorkQueue *queues;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;     // Signaled when tasks were submitted or the pool stops
+    pthread_cond_t idle;     // Signaled when all the submitted tasks are finished
+    int queued;              // Tasks waiting in the queues
+    int pending;             // Tasks submitted but not finished
+    bool stop;
+} ThreadPool;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+int GetProcessorCount(void);
+bool InitThreadPool(ThreadPool *pool, int workers);
+void UnloadThreadPool(ThreadPool *pool);
+void SubmitTask(ThreadPool *pool, int worker, TaskFunction function, void *arg);
+void WaitThreadPool(ThreadPool *pool);
+
+#endif  // THREADPOOL_H
@@ -0,0 +1,86 @@
+#if defined(_WIN32)
+#include <windows.h>  // QueryPerformanceCounter, QueryPerformanceFrequency, GetProcessTimes
+#else
+#include <time.h>     // clock_gettime, CLOCK_MONOTONIC, CLOCK_PROCESS_CPUTIME_ID
+#endif
+
+#include "timer.h"
+
+//-------------------------------------------------------------------------------------------------
+// Functions Definition
+//-------------------------------------------------------------------------------------------------
+double GetMonotonicTime(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (!frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+double GetProcessCpuTime(void)
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0.0;
+
+    // 100 ns units
+    return (((unsigned long long)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime) +
+            ((unsigned long long)user.dwHighDateTime << 32 | user.dwLowDateTime)) * 1e-7;
+#else
+    struct timespec used;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &used);
+
+    return used.tv_sec + used.tv_nsec * 1e-9;
+#endif
+}
+
+void InitStepClock(StepClock *ticker, double step, int maxSteps)
+{
+    ticker->step     = step;
+    ticker->maxSteps = maxSteps;
+
+    ResetStepClock(ticker);
+}
+
+// Start counting from now, the time before is not simulated
+void ResetStepClock(StepClock *ticker)
+{
+    ticker->lag  = 0;
+    ticker->last = GetMonotonicTime();
+}
+
+// Returns the number of logic steps to run for the time elapsed since the last call
+int AdvanceStepClock(StepClock *ticker)
+{
+    double now = GetMonotonicTime();
+    int steps;
+
+    ticker->lag += now - ticker->last;
+    ticker->last = now;
+
+    steps = (int)(ticker->lag / ticker->step);
+
+    // Don't spiral after a stall (a dragged window, a breakpoint), slow down instead
+    if (steps > ticker->maxSteps)
+    {
+        steps = ticker->maxSteps;
+        ticker->lag = steps * ticker->step;
+    }
+
+    ticker->lag -= steps * ticker->step;
+
+    return steps;
+}
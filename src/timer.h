@@ -0,0 +1,29 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+
+/*
+ * Fixed timestep clock. Every frame it turns the elapsed time into whole logic
+ * steps, the time left over is the lag the renderer interpolates with.
+ */
+typedef struct {
+    double step;        // Seconds of a logic step
+    double lag;         // Seconds elapsed but not simulated yet, less than a step
+    double last;        // Time of the last advance
+    int maxSteps;       // Steps of a frame at most, a longer stall is dropped
+} StepClock;
+
+//-------------------------------------------------------------------------------------------------
+// Functions Declaration
+//-------------------------------------------------------------------------------------------------
+double GetMonotonicTime(void);    // Seconds from an arbitrary point, never goes backwards
+double GetProcessCpuTime(void);   // Seconds of CPU time used by all the threads of the process
+
+void InitStepClock(StepClock *ticker, double step, int maxSteps);
+void ResetStepClock(StepClock *ticker);
+int AdvanceStepClock(StepClock *ticker);
+
+#endif  // TIMER_H
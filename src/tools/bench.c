@@ -0,0 +1,888 @@
+/*
+ * Microbenchmark suite for the hot paths of the game. Every benchmark runs
+ * on the synthetic boards (empty, half-full, jammed, late-game) and reports
+ * the time per operation as JSON. With a baseline file the results are
+ * compared against it and the regressions beyond the threshold fail the run.
+ *
+ *   bench [-o results.json] [-b baseline.json] [-t percent] [-f filter]
+ *
+ * The moves of the runtime sized grids (3x3 to 8x8) run on one set of random
+ * mid-game grids per size, the 4x4 one goes through the bitboard tables.
+ * The rounded rectangle geometry is measured without a window too, together
+ * with a report of the vertices and the draw calls of a gameplay frame.
+ * The logic benchmarks need no window. Building with BENCH_GAME (make
+ * bench-game) adds the save/load, the rounded rectangle and the tile label
+ * benchmarks, they link the game modules and raylib and open a window.
+ */
+
+#include <math.h>    // sinf, cosf
+#include <stdio.h>   // printf, fprintf, fopen, fclose, tmpfile
+#include <stdlib.h>  // atof, malloc, free
+#include <string.h>  // strcmp, strstr, strchr
+#include "../batch.h"
+#include "../bitboard.h"
+#include "../geometry.h"
+#include "../grid.h"
+#include "../journal.h"
+#include "../random.h"
+#include "../saver.h"
+#include "../timer.h"
+
+#if defined(BENCH_GAME)
+    #include "raylib.h"
+    #include "../game.h"
+    #include "../shapes.h"
+    #include "../textcache.h"
+#endif
+
+#define MAX_RESULTS          256
+#define MAX_NAME_LENGTH      64
+#define BENCH_MIN_TIME       0.05    // Seconds a single measurement should take at least
+#define BENCH_REPEATS        5       // The fastest of the repeated measurements is reported
+#define DEFAULT_THRESHOLD    10.0    // Percent
+#define BATCH_BOARDS         1024
+#define GRID_CASES           64      // Random grids per size, the moves cycle through them
+#define SINCOS_MAX_VERTICES  (3*4 + 4*5*4)    // Rounded rectangle of the former corner fans
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef void (*BenchFunction)(void *arg, long iterations);
+
+typedef struct {
+    char name[MAX_NAME_LENGTH];
+    double nsPerOp;
+    long iterations;
+} BenchResult;
+
+typedef struct {
+    const char *name;
+    Bitboard board;
+} BoardCase;
+
+typedef struct {
+    Bitboard board;
+    Direction direction;
+} MoveArgs;
+
+typedef struct {
+    const char *name;
+    SyncPolicy policy;
+} SyncCase;
+
+typedef enum { TEXTURE_SHAPES, TEXTURE_FONT, TEXTURE_ATLAS } FrameTexture;
+
+typedef struct {
+    int vertices;
+    int drawCalls;           // A new draw call starts whenever the texture changes
+    FrameTexture texture;
+} FrameCount;
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static void RunBenchmark(const char *name, BenchFunction function, void *arg);
+static void WriteResults(FILE *file);
+static int CompareBaseline(const char *path, double threshold);
+
+static void BenchMove(void *arg, long iterations);
+static void BenchAddTile(void *arg, long iterations);
+static void BenchMoveIsAvailable(void *arg, long iterations);
+static void BenchGridIsFull(void *arg, long iterations);
+static void BenchMoveBatch(void *arg, long iterations);
+static void BenchGridMove(void *arg, long iterations);
+static void BenchGridCanMove(void *arg, long iterations);
+static void BenchJournalAppend(void *arg, long iterations);
+static void BenchSubmitSave(void *arg, long iterations);
+static void BenchJournalReplay(void *arg, long iterations);
+static FILE *RecordJournal(int moves);
+static void BenchRoundedRectangleSinCos(void *arg, long iterations);
+static void BenchRoundedRectangleTable(void *arg, long iterations);
+static int BuildSinCosRoundedRectangle(float x, float y, float width, float height,
+                                       float radius, GeometryVertex *vertices);
+static void ReportRenderFrame(void);
+static void AddFrameDraw(FrameCount *frame, FrameTexture texture, int vertices);
+static void AddFrameRectangle(FrameCount *frame, float x, float y, float size, float radius,
+                              bool sincos);
+static void AddFrameText(FrameCount *frame, FrameTexture texture, const char *text);
+#if defined(BENCH_GAME)
+static void BenchSaveGame(void *arg, long iterations);
+static void BenchLoadGame(void *arg, long iterations);
+static void BenchRoundedRectangle(void *arg, long iterations);
+static void BenchTileLabel(void *arg, long iterations);
+static void BenchTileLabelCached(void *arg, long iterations);
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static BenchResult results[MAX_RESULTS];
+static int resultCount = 0;
+static const char *filter = NULL;
+
+static volatile uint64_t sink;    // Keeps the benchmarked results alive
+static RandomGenerator generator;
+
+static const char *directionNames[MOVE_COUNT] = { "left", "right", "up", "down" };
+
+/*
+ * Cell (x, y) is the nibble y*4 + x, the hexadecimal literals read from the
+ * bottom right cell to the top left one.
+ */
+static const BoardCase boardCases[] = {
+    { "empty",     0x0000000000000000ULL },    // Nothing to move
+    { "half-full", 0x0000000012302101ULL },    // 6 small tiles in the top two rows
+    { "jammed",    0x1212212112122121ULL },    // Full grid, no moves left
+    { "late-game", 0x0123456789ABCDE1ULL },    // Snake of big tiles with a gap
+};
+
+static const SyncCase syncPolicies[] = {
+    { "sync_never",      { SYNC_NEVER, 0, 0.0 } },
+    { "sync_every_move", { SYNC_EVERY_MOVE, 0, 0.0 } },
+    { "sync_every_16",   { SYNC_EVERY_MOVES, 16, 0.0 } },
+    { "sync_every_50ms", { SYNC_INTERVAL, 0, 0.05 } },
+};
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark entry point
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    const char *output = NULL;
+    const char *baseline = NULL;
+    double threshold = DEFAULT_THRESHOLD;
+    char name[MAX_NAME_LENGTH];
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) output = argv[++i];
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) baseline = argv[++i];
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) threshold = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) filter = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [-o results.json] [-b baseline.json] [-t percent] "
+                            "[-f filter]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    InitMoveTables();
+    SeedRandomGenerator(&generator, 1);
+
+    for (size_t c = 0; c < sizeof(boardCases)/sizeof(boardCases[0]); c++)
+    {
+        const BoardCase *board = &boardCases[c];
+
+        for (int d = 0; d < MOVE_COUNT; d++)
+        {
+            MoveArgs args = { board->board, d };
+
+            snprintf(name, sizeof(name), "move_%s/%s", directionNames[d], board->name);
+            RunBenchmark(name, BenchMove, &args);
+        }
+
+        snprintf(name, sizeof(name), "add_tile/%s", board->name);
+        RunBenchmark(name, BenchAddTile, (void *)board);
+
+        snprintf(name, sizeof(name), "move_is_available/%s", board->name);
+        RunBenchmark(name, BenchMoveIsAvailable, (void *)board);
+
+        snprintf(name, sizeof(name), "grid_is_full/%s", board->name);
+        RunBenchmark(name, BenchGridIsFull, (void *)board);
+    }
+
+    for (int kernel = 0; kernel < BATCH_KERNEL_COUNT; kernel++)
+    {
+        if (!SetBatchKernel(kernel)) continue;
+
+        snprintf(name, sizeof(name), "move_batch/%s", GetBatchKernelName(kernel));
+        RunBenchmark(name, BenchMoveBatch, NULL);
+    }
+
+    for (int size = GRID_MIN_SIZE; size <= GRID_MAX_SIZE; size++)
+    {
+        snprintf(name, sizeof(name), "grid_move/%dx%d", size, size);
+        RunBenchmark(name, BenchGridMove, &size);
+
+        snprintf(name, sizeof(name), "grid_can_move/%dx%d", size, size);
+        RunBenchmark(name, BenchGridCanMove, &size);
+    }
+
+    Journal journal = { 0 };
+
+    journal.file     = tmpfile();
+    journal.interval = JOURNAL_SNAPSHOT_INTERVAL;
+
+    if (journal.file)
+    {
+        Saver saver;
+
+        // The cost per save of every sync policy, the file is a real file in the temp directory
+        for (size_t i = 0; i < sizeof(syncPolicies)/sizeof(syncPolicies[0]); i++)
+        {
+            SetJournalSyncPolicy(&journal, syncPolicies[i].policy);
+
+            snprintf(name, sizeof(name), "journal_append/%s", syncPolicies[i].name);
+            RunBenchmark(name, BenchJournalAppend, &journal);
+        }
+
+        SetJournalSyncPolicy(&journal, (SyncPolicy){ SYNC_NEVER, 0, 0.0 });
+        InitSaver(&saver, &journal);
+        RunBenchmark("submit_save", BenchSubmitSave, &saver);
+        SaveStats stats = GetSaveStats(&saver);
+
+        UnloadSaver(&saver);
+        if (stats.queued)
+        {
+            fprintf(stderr, "%-32s %llu queued, %llu coalesced, %llu written, worst %.3f ms\n",
+                    "submit_save stats", stats.queued, stats.coalesced, stats.written,
+                    stats.maxLatency * 1000);
+        }
+
+        CloseJournal(&journal);
+    }
+
+    FILE *recorded = RecordJournal(JOURNAL_SNAPSHOT_INTERVAL - 1);
+
+    if (recorded)
+    {
+        RunBenchmark("journal_replay", BenchJournalReplay, recorded);
+        fclose(recorded);
+    }
+
+    RunBenchmark("rounded_rect/sincos", BenchRoundedRectangleSinCos, NULL);
+    RunBenchmark("rounded_rect/table", BenchRoundedRectangleTable, NULL);
+
+    if (!filter || strstr("render_frame", filter)) ReportRenderFrame();
+
+#if defined(BENCH_GAME)
+    Game game = { 0 };
+    FILE *file = tmpfile();
+
+    BitboardToGrid(boardCases[3].board, &game.board.grid);
+
+    if (file)
+    {
+        WriteGame(file, &game);
+
+        RunBenchmark("save_game", BenchSaveGame, file);
+        RunBenchmark("load_game", BenchLoadGame, file);
+        fclose(file);
+    }
+
+    SetTraceLog(LOG_WARNING | LOG_ERROR);
+    InitWindow(420, 640, "bench");
+
+    BeginDrawing();
+    RunBenchmark("draw_rounded_rectangle", BenchRoundedRectangle, NULL);
+    EndDrawing();
+
+    RunBenchmark("tile_label/sprintf_measure", BenchTileLabel, NULL);
+    RunBenchmark("tile_label/cached", BenchTileLabelCached, NULL);
+
+    CloseWindow();
+#endif
+
+    if (output)
+    {
+        FILE *out = fopen(output, "w");
+
+        if (!out)
+        {
+            fprintf(stderr, "Can't open %s\n", output);
+            return 1;
+        }
+
+        WriteResults(out);
+        fclose(out);
+    }
+    else
+    {
+        WriteResults(stdout);
+    }
+
+    return baseline ? CompareBaseline(baseline, threshold) : 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+/*
+ * Double the iterations until a run takes BENCH_MIN_TIME, then repeat the
+ * run and keep the fastest one, it is the least disturbed by the system.
+ */
+static void RunBenchmark(const char *name, BenchFunction function, void *arg)
+{
+    if (filter && !strstr(name, filter)) return;
+    if (resultCount == MAX_RESULTS) return;
+
+    long iterations = 1;
+    double elapsed = 0.0;
+
+    for (;;)
+    {
+        double start = GetMonotonicTime();
+        function(arg, iterations);
+        elapsed = GetMonotonicTime() - start;
+
+        if (elapsed >= BENCH_MIN_TIME) break;
+        iterations *= 2;
+    }
+
+    for (int i = 1; i < BENCH_REPEATS; i++)
+    {
+        double start = GetMonotonicTime();
+        function(arg, iterations);
+        double time = GetMonotonicTime() - start;
+
+        if (time < elapsed) elapsed = time;
+    }
+
+    BenchResult *result = &results[resultCount++];
+
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->nsPerOp    = elapsed * 1e9 / iterations;
+    result->iterations = iterations;
+
+    fprintf(stderr, "%-32s %10.2f ns/op\n", name, result->nsPerOp);
+}
+
+static void WriteResults(FILE *file)
+{
+    fprintf(file, "{\n  \"benchmarks\": [\n");
+
+    for (int i = 0; i < resultCount; i++)
+    {
+        fprintf(file, "    { \"name\": \"%s\", \"ns_per_op\": %.3f, \"iterations\": %ld }%s\n",
+                results[i].name, results[i].nsPerOp, results[i].iterations,
+                (i + 1 < resultCount) ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+}
+
+/*
+ * The baseline is a file written by this tool, so the parser only looks for
+ * the name and ns_per_op pairs. Returns 1 if any benchmark got slower than
+ * the threshold allows.
+ */
+static int CompareBaseline(const char *path, double threshold)
+{
+    FILE *file = fopen(path, "rb");
+    int regressions = 0;
+
+    if (!file)
+    {
+        fprintf(stderr, "Can't open baseline %s\n", path);
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *data = malloc(size + 1);
+    if (!data || fread(data, 1, size, file) != (size_t)size)
+    {
+        free(data);
+        fclose(file);
+        return 1;
+    }
+    data[size] = '\0';
+    fclose(file);
+
+    fprintf(stderr, "\nComparison with %s (threshold %.1f%%):\n", path, threshold);
+
+    for (char *cursor = strstr(data, "\"name\": \""); cursor; cursor = strstr(cursor, "\"name\": \""))
+    {
+        char name[MAX_NAME_LENGTH] = { 0 };
+        cursor += strlen("\"name\": \"");
+
+        char *end = strchr(cursor, '"');
+        if (!end) break;
+
+        snprintf(name, sizeof(name), "%.*s", (int)(end - cursor), cursor);
+
+        char *value = strstr(end, "\"ns_per_op\": ");
+        if (!value) break;
+
+        double base = atof(value + strlen("\"ns_per_op\": "));
+
+        for (int i = 0; i < resultCount; i++)
+        {
+            if (strcmp(results[i].name, name) || base <= 0) continue;
+
+            double change = 100.0 * (results[i].nsPerOp - base) / base;
+            bool regressed = change > threshold;
+
+            fprintf(stderr, "%-32s %10.2f -> %10.2f ns/op %+7.1f%%%s\n", name, base,
+                    results[i].nsPerOp, change, regressed ? "  REGRESSION" : "");
+
+            if (regressed) regressions++;
+        }
+
+        cursor = end;
+    }
+
+    free(data);
+
+    if (regressions) fprintf(stderr, "%d regression(s) beyond %.1f%%\n", regressions, threshold);
+
+    return regressions ? 1 : 0;
+}
+
+// The board is read through a volatile so the compiler can't hoist the move out of the loop
+static void BenchMove(void *arg, long iterations)
+{
+    MoveArgs *args = arg;
+    uint64_t sum = 0;
+    unsigned int score;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        Bitboard board = *(volatile Bitboard *)&args->board;
+        sum += ExecuteMove(board, args->direction, &score) + score;
+    }
+    sink = sum;
+}
+
+static void BenchAddTile(void *arg, long iterations)
+{
+    const BoardCase *board = arg;
+    uint64_t sum = 0;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        Bitboard copy = *(volatile const Bitboard *)&board->board;
+        sum += SpawnTile(&copy, &generator) + copy;
+    }
+    sink = sum;
+}
+
+static void BenchMoveIsAvailable(void *arg, long iterations)
+{
+    const BoardCase *board = arg;
+    uint64_t sum = 0;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += CanMove(*(volatile const Bitboard *)&board->board);
+    }
+    sink = sum;
+}
+
+static void BenchGridIsFull(void *arg, long iterations)
+{
+    const BoardCase *board = arg;
+    uint64_t sum = 0;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += CountEmptyCells(*(volatile const Bitboard *)&board->board) == 0;
+    }
+    sink = sum;
+}
+
+// One operation is a single board moved by the current batch kernel
+static void BenchMoveBatch(void *arg, long iterations)
+{
+    static Bitboard boards[BATCH_BOARDS], moved[BATCH_BOARDS];
+    static Direction directions[BATCH_BOARDS];
+    static unsigned int scores[BATCH_BOARDS];
+    static bool changed[BATCH_BOARDS];
+    const size_t cases = sizeof(boardCases)/sizeof(boardCases[0]);
+
+    for (int i = 0; i < BATCH_BOARDS; i++)
+    {
+        boards[i]     = boardCases[i % cases].board;
+        directions[i] = (i / cases) % MOVE_COUNT;
+    }
+
+    for (long done = 0; done < iterations; done += BATCH_BOARDS)
+    {
+        long count = iterations - done < BATCH_BOARDS ? iterations - done : BATCH_BOARDS;
+        MoveBatch(boards, directions, count, moved, scores, changed);
+    }
+    sink = moved[0];
+}
+
+// One operation copies one of the grids and moves it, the directions rotate
+static void BenchGridMove(void *arg, long iterations)
+{
+    static Grid grids[GRID_CASES];
+    int size = *(int *)arg;
+    uint64_t sum = 0;
+    RandomGenerator random;
+
+    SeedRandomGenerator(&random, size);
+
+    // Half of the cells hold small tiles, like the middle of a game
+    for (int i = 0; i < GRID_CASES; i++)
+    {
+        InitGrid(&grids[i], size);
+
+        for (int cell = 0; cell < size*size; cell++)
+        {
+            if (NextRandomBelow(&random, 2))
+            {
+                SetGridCell(&grids[i], cell, 1 + NextRandomBelow(&random, 6));
+            }
+        }
+    }
+
+    for (long i = 0; i < iterations; i++)
+    {
+        Grid grid = grids[i % GRID_CASES];
+        unsigned int score;
+
+        sum += MoveGrid(&grid, (i / GRID_CASES) % MOVE_COUNT, &score) + score +
+               GetGridCell(&grid, 0);
+    }
+    sink = sum;
+}
+
+// The grid is a jammed checkerboard, the check has to look at every cell
+static void BenchGridCanMove(void *arg, long iterations)
+{
+    static Grid grid;
+    const Grid *volatile pointer = &grid;    // The compiler can't hoist the check out of the loop
+    int size = *(int *)arg;
+    uint64_t sum = 0;
+
+    InitGrid(&grid, size);
+
+    for (int cell = 0; cell < size*size; cell++)
+    {
+        SetGridCell(&grid, cell, 1 + (cell % size + cell / size) % 2);
+    }
+
+    for (long i = 0; i < iterations; i++) sum += CanMoveGrid(pointer);
+
+    sink = sum;
+}
+
+// One operation is a move record, every JOURNAL_SNAPSHOT_INTERVAL one appends a snapshot too
+static void BenchJournalAppend(void *arg, long iterations)
+{
+    Journal *journal = arg;
+    JournalSnapshot snapshot = { .cells = boardCases[3].board };
+    JournalMove move = { MOVE_LEFT, 15, 1 };
+
+    rewind(journal->file);
+
+    for (long i = 0; i < iterations; i++)
+    {
+        AppendJournalMove(journal, move, &snapshot);
+    }
+}
+
+// Time the game thread spends on a save, the writing happens on the I/O thread
+static void BenchSubmitSave(void *arg, long iterations)
+{
+    SaveRequest request = { .type = SAVE_MOVE, .move = { MOVE_LEFT, 15, 1 } };
+
+    request.state.cells = boardCases[3].board;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        request.submitted = GetMonotonicTime();
+        SubmitSave(arg, &request);
+    }
+    FlushSaver(arg);
+}
+
+// Load of the worst case journal: a snapshot followed by the longest run of moves
+static void BenchJournalReplay(void *arg, long iterations)
+{
+    JournalSnapshot snapshot;
+    long end;
+    uint64_t sum = 0;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += ReplayJournal(arg, &snapshot, &end) + snapshot.score;
+    }
+    sink = sum;
+}
+
+// Play the moves with the first direction that changes the board and journal them
+static FILE *RecordJournal(int moves)
+{
+    Journal journal = { .file = tmpfile(), .interval = moves + 1 };
+    JournalSnapshot state = { .seed = 1 };
+
+    if (!journal.file) return NULL;
+
+    SeedRandomGenerator(&state.random, state.seed);
+    SpawnTile(&state.cells, &state.random);
+    SpawnTile(&state.cells, &state.random);
+    WriteJournal(journal.file, &state);
+
+    for (int i = 0; i < moves; i++)
+    {
+        JournalMove move = { MOVE_LEFT, 0, 0 };
+        unsigned int score;
+        Bitboard cells = state.cells;
+
+        while (move.direction < MOVE_COUNT &&
+               (cells = ExecuteMove(state.cells, move.direction, &score)) == state.cells)
+        {
+            move.direction++;
+        }
+
+        if (move.direction == MOVE_COUNT) break;
+
+        move.cell    = SpawnTile(&cells, &state.random);
+        move.value   = GetCell(cells, move.cell);
+        state.cells  = cells;
+        state.score += score;
+        state.best   = state.score;
+
+        AppendJournalMove(&journal, move, &state);
+    }
+
+    return journal.file;
+}
+
+// Tile sized rectangle with the corner fans of sinf/cosf every 10 degrees the game used to draw
+static void BenchRoundedRectangleSinCos(void *arg, long iterations)
+{
+    GeometryVertex vertices[SINCOS_MAX_VERTICES];
+    float sum = 0;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        BuildSinCosRoundedRectangle(40 + (i & 7), 240, 80, 80, 4, vertices);
+        sum += vertices[SINCOS_MAX_VERTICES - 1].x;
+    }
+    sink = sum;
+}
+
+static void BenchRoundedRectangleTable(void *arg, long iterations)
+{
+    GeometryVertex vertices[GEOMETRY_MAX_VERTICES];
+    float sum = 0;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        int count = BuildRoundedRectangle(40 + (i & 7), 240, 80, 80, 4, vertices);
+        sum += vertices[count - 1].x;
+    }
+    sink = sum;
+}
+
+// The corners of the former DrawCirclePro(), quads of 20 degrees from the start angle to the end
+static int BuildSinCosRoundedRectangle(float x, float y, float width, float height,
+                                       float radius, GeometryVertex *vertices)
+{
+    const float degrees = 3.14159265f/180.0f;
+    const struct { float x, y; int start; } corners[4] = {
+        { x + radius, y + radius, 180 }, { x + radius, y + height - radius, 270 },
+        { x + width - radius, y + radius, 90 }, { x + width - radius, y + height - radius, 0 }
+    };
+    GeometryVertex *v = vertices;
+
+    for (int c = 0; c < 4; c++)
+    {
+        for (int i = corners[c].start; i <= corners[c].start + 90; i += 20)
+        {
+            *v++ = (GeometryVertex){ corners[c].x, corners[c].y };
+
+            for (int k = 0; k <= 20; k += 10)
+            {
+                *v++ = (GeometryVertex){ corners[c].x + sinf(degrees*(i + k))*radius,
+                                         corners[c].y + cosf(degrees*(i + k))*radius };
+            }
+        }
+    }
+
+    // Vertical and the two horizontal rectangles
+    for (int r = 0; r < 3; r++)
+    {
+        for (int k = 0; k < 4; k++) *v++ = (GeometryVertex){ x + r*radius, y + k*radius };
+    }
+
+    return (int)(v - vertices);
+}
+
+/*
+ * Estimated vertices and draw calls of a late game frame of the gameplay
+ * screen at the default window size, before (rounded rectangles of sinf/cosf
+ * corner fans and a text per tile, in the former drawing order) and after
+ * (tile atlas, table corners, draws grouped by the texture). This is a model:
+ * it copies the draw order of screen_play.c and board.c by hand and measures
+ * nothing, it has to be updated whenever that order changes. Every rlgl
+ * texture change starts a new draw call and the default font shares the
+ * shapes texture.
+ */
+static void ReportRenderFrame(void)
+{
+    const float width = 420, height = 640;
+    const float board = width*0.84f, spacing = board*0.03f, tile = (board - 5*spacing)/4;
+    const struct { float x, y, w, h, radius; } panels[4] = {
+        { width*0.08f, height*0.05f, width*0.26f, width*0.26f, width*0.26f*0.05f },
+        { width*0.46f, height*0.05f, width*0.21f, height*0.085f, width*0.21f*0.05f },
+        { width*0.7f, height*0.05f, width*0.21f, height*0.085f, width*0.21f*0.05f },
+        { width*0.64f, height*0.16f, width*0.27f, height*0.06f, width*0.27f*0.04f },
+    };
+    const char *panelTexts[4][2] = {
+        { "2048", NULL }, { "SCORE", "24516" }, { "BEST", "30276" }, { "New Game", NULL }
+    };
+    const char *purpose = "Join the numbers and get to the 4096 tile!";
+    Bitboard cells = boardCases[3].board;
+    char label[12];
+
+    for (int after = 0; after < 2; after++)
+    {
+        FrameCount frame = { 0 };
+        int tiles = 0;
+
+        for (int i = 0; i < BITBOARD_CELLS; i++) tiles += (GetCell(cells, i) != 0);
+
+        if (after)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                AddFrameRectangle(&frame, panels[i].x, panels[i].y, panels[i].w,
+                                  panels[i].radius, false);
+            }
+
+            AddFrameText(&frame, TEXTURE_SHAPES, panelTexts[0][0]);
+            AddFrameText(&frame, TEXTURE_SHAPES, panelTexts[1][1]);
+            AddFrameText(&frame, TEXTURE_SHAPES, panelTexts[2][1]);
+            AddFrameRectangle(&frame, 0, 0, board, board*0.015f, false);
+            AddFrameDraw(&frame, TEXTURE_ATLAS, (BITBOARD_CELLS + tiles)*4);    // Atlas quads
+
+            for (int i = 1; i < 4; i++) AddFrameText(&frame, TEXTURE_FONT, panelTexts[i][0]);
+        }
+        else
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                AddFrameRectangle(&frame, panels[i].x, panels[i].y, panels[i].w,
+                                  panels[i].radius, true);
+                AddFrameText(&frame, (i == 0) ? TEXTURE_SHAPES : TEXTURE_FONT, panelTexts[i][0]);
+                if (panelTexts[i][1]) AddFrameText(&frame, TEXTURE_SHAPES, panelTexts[i][1]);
+            }
+        }
+
+        AddFrameText(&frame, TEXTURE_FONT, purpose);
+
+        if (!after)
+        {
+            AddFrameRectangle(&frame, 0, 0, board, board*0.015f, true);
+
+            for (int i = 0; i < BITBOARD_CELLS; i++) AddFrameRectangle(&frame, 0, 0, tile,
+                                                                       tile*0.05f, true);
+
+            for (int i = 0; i < BITBOARD_CELLS; i++)
+            {
+                if (!GetCell(cells, i)) continue;
+
+                snprintf(label, sizeof(label), "%u", 2u << (GetCell(cells, i) - 1));
+                AddFrameRectangle(&frame, 0, 0, tile, tile*0.05f, true);
+                AddFrameText(&frame, TEXTURE_SHAPES, label);
+            }
+        }
+
+        fprintf(stderr, "%-32s %d vertices, %d draw calls (modelled, not measured)\n",
+                after ? "render_frame model after" : "render_frame model before",
+                frame.vertices, frame.drawCalls);
+    }
+}
+
+static void AddFrameDraw(FrameCount *frame, FrameTexture texture, int vertices)
+{
+    if (frame->drawCalls == 0 || frame->texture != texture) frame->drawCalls++;
+
+    frame->texture   = texture;
+    frame->vertices += vertices;
+}
+
+static void AddFrameRectangle(FrameCount *frame, float x, float y, float size, float radius,
+                              bool sincos)
+{
+    GeometryVertex vertices[GEOMETRY_MAX_VERTICES > SINCOS_MAX_VERTICES ?
+                            GEOMETRY_MAX_VERTICES : SINCOS_MAX_VERTICES];
+    int count = sincos ? BuildSinCosRoundedRectangle(x, y, size, size, radius, vertices)
+                       : BuildRoundedRectangle(x, y, size, size, radius, vertices);
+
+    AddFrameDraw(frame, TEXTURE_SHAPES, count);
+}
+
+// A quad per visible glyph
+static void AddFrameText(FrameCount *frame, FrameTexture texture, const char *text)
+{
+    int glyphs = 0;
+
+    for (const char *c = text; *c; c++) glyphs += (*c != ' ');
+
+    AddFrameDraw(frame, texture, glyphs*4);
+}
+
+#if defined(BENCH_GAME)
+static void BenchSaveGame(void *arg, long iterations)
+{
+    Game game = { 0 };
+
+    BitboardToGrid(boardCases[3].board, &game.board.grid);
+
+    for (long i = 0; i < iterations; i++)
+    {
+        WriteGame(arg, &game);
+    }
+    fflush(arg);
+}
+
+static void BenchLoadGame(void *arg, long iterations)
+{
+    Game game;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        fseek(arg, 0, SEEK_SET);
+        ReadGame(arg, &game);
+    }
+    sink = GridToBitboard(&game.board.grid);
+}
+
+// Draw a tile sized rectangle and flush the batch every 1000 rectangles
+static void BenchRoundedRectangle(void *arg, long iterations)
+{
+    Rectangle rec = { 40, 240, 80, 80 };
+
+    for (long i = 0; i < iterations; i++)
+    {
+        DrawRoundedRectangleRec(rec, rec.width * 0.05f, (Color){ 237, 194, 46, 255 });
+        if (i % 1000 == 999) rlglDraw();
+    }
+    rlglDraw();
+}
+
+// Format and measure the labels of the 16 tiles of a late game board like DrawBoard() used to
+static void BenchTileLabel(void *arg, long iterations)
+{
+    char buffer[12];
+    int width = 0;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        sprintf(buffer, "%d", 2 << (i % 16));
+        width += MeasureText(buffer, 40);
+    }
+    sink = width;
+}
+
+static void BenchTileLabelCached(void *arg, long iterations)
+{
+    float width = 0;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        width += GetNumberLayout(NULL, 40, 2u << (i % 16))->extent.x;
+    }
+    sink = width;
+}
+#endif
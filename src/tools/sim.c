@@ -0,0 +1,549 @@
+/*
+ * Headless simulation runner. Plays games with the selected policy at full
+ * speed on top of the logic core only, there is no window, audio or GPU
+ * involved. Used as the throughput baseline for the game logic.
+ *
+ *   sim [-n games] [-p random|greedy|corner|expectimax] [-s seed] [-d depth] [-t ms]
+ *       [-j threads] [--scaling] [--batch] [--huge]
+ *
+ * The --scaling mode runs the fixed depth search over a set of positions with
+ * one thread and with the -j threads and reports nodes/sec and the speedup.
+ * The --batch mode checks every supported batch move kernel against the
+ * scalar moves and reports boards/sec. The --huge mode plays the big grids
+ * from 8x8 to 1024x1024 on one thread and on the -j threads and reports
+ * moves/sec and the speedup.
+ */
+
+#include <stdio.h>   // printf, fprintf
+#include <stdlib.h>  // atoi, malloc, free, qsort, strtoull
+#include <string.h>  // strcmp
+#include "../batch.h"
+#include "../bitboard.h"
+#include "../hugegrid.h"
+#include "../random.h"
+#include "../solver.h"
+#include "../timer.h"
+
+#define DEFAULT_GAMES       1000
+#define SCALING_POSITIONS   24
+#define SCALING_DEPTH       4
+#define BATCH_BOARDS        4096
+#define BATCH_ROUNDS        2000
+#define HUGE_CELL_MOVES     (1 << 26)    // Cells moved per size, 64 moves of 1024x1024
+
+//-------------------------------------------------------------------------------------------------
+// Types and Structures Definition
+//-------------------------------------------------------------------------------------------------
+typedef Direction (*Policy)(Bitboard board, RandomGenerator *random);
+
+typedef struct {
+    const char *name;
+    Policy policy;
+} PolicyEntry;
+
+typedef struct {
+    unsigned int score;
+    unsigned int moves;
+    unsigned int max;
+} GameResult;
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Declaration
+//-------------------------------------------------------------------------------------------------
+static Direction RandomPolicy(Bitboard board, RandomGenerator *random);
+static Direction GreedyPolicy(Bitboard board, RandomGenerator *random);
+static Direction CornerPolicy(Bitboard board, RandomGenerator *random);
+static Direction ExpectimaxPolicy(Bitboard board, RandomGenerator *random);
+
+static GameResult PlayGame(Policy policy, RandomGenerator *random);
+static void PrintReport(GameResult *results, int games, double elapsed);
+static int RunScaling(SolverConfig config, RandomGenerator *random);
+static int RunBatch(RandomGenerator *random);
+static int RunHuge(int threads, RandomGenerator *random);
+static bool PlayHugeGrid(int size, ThreadPool *pool, RandomGenerator random, long moves,
+                         uint64_t *score, double *elapsed);
+static int CompareScores(const void *a, const void *b);
+
+//-------------------------------------------------------------------------------------------------
+// Local Variables Definition
+//-------------------------------------------------------------------------------------------------
+static const PolicyEntry policies[] = {
+    { "random", RandomPolicy },
+    { "greedy", GreedyPolicy },
+    { "corner", CornerPolicy },
+    { "expectimax", ExpectimaxPolicy },
+};
+
+static Solver solver;
+static unsigned long long searchNodes = 0;
+static unsigned long long searchCount = 0;
+static double searchTime = 0.0;
+
+//-------------------------------------------------------------------------------------------------
+// Simulation entry point
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    int games = DEFAULT_GAMES;
+    unsigned long long seed = 1;
+    RandomGenerator random;
+    const PolicyEntry *entry = &policies[0];
+    SolverConfig config = GetDefaultSolverConfig();
+    bool scaling = false;
+    bool batch = false;
+    bool huge = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) games = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc) config.maxDepth = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) config.timeBudget = atof(argv[++i])/1000;
+        else if (!strcmp(argv[i], "-j") && i + 1 < argc) config.threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--scaling")) scaling = true;
+        else if (!strcmp(argv[i], "--batch")) batch = true;
+        else if (!strcmp(argv[i], "--huge")) huge = true;
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+
+            entry = NULL;
+            for (size_t p = 0; p < sizeof(policies)/sizeof(policies[0]); p++)
+            {
+                if (!strcmp(policies[p].name, name)) entry = &policies[p];
+            }
+
+            if (!entry)
+            {
+                fprintf(stderr, "Unknown policy: %s\n", name);
+                return 1;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-n games] [-p random|greedy|corner|expectimax] "
+                            "[-s seed] [-d depth] [-t ms] [-j threads] [--scaling] [--batch] "
+                            "[--huge]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (games <= 0) games = DEFAULT_GAMES;
+
+    SeedRandomGenerator(&random, seed);
+
+    if (huge) return RunHuge(config.threads, &random);
+
+    if (scaling || batch)
+    {
+        return scaling ? RunScaling(config, &random) : RunBatch(&random);
+    }
+
+    GameResult *results = malloc(sizeof(GameResult) * games);
+    if (!results) return 1;
+
+    InitMoveTables();
+
+    if (entry->policy == ExpectimaxPolicy && !InitSolver(&solver, config))
+    {
+        fprintf(stderr, "Solver transposition table allocation failed\n");
+        free(results);
+        return 1;
+    }
+
+    printf("policy: %s, games: %d, seed: %llu", entry->name, games, seed);
+    if (entry->policy == ExpectimaxPolicy) printf(", threads: %d", solver.config.threads);
+    printf("\n");
+
+    double start = GetMonotonicTime();
+
+    // Every game gets its own stream, a game replays the same regardless of the games before it
+    for (int i = 0; i < games; i++)
+    {
+        RandomGenerator stream = random;
+
+        JumpRandomGenerator(&random);
+        results[i] = PlayGame(entry->policy, &stream);
+    }
+
+    PrintReport(results, games, GetMonotonicTime() - start);
+    free(results);
+
+    if (entry->policy == ExpectimaxPolicy) UnloadSolver(&solver);
+
+    return 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Local Functions Definition
+//-------------------------------------------------------------------------------------------------
+
+// Pick any move that changes the board
+static Direction RandomPolicy(Bitboard board, RandomGenerator *random)
+{
+    int count = 0;
+    Direction available[MOVE_COUNT];
+
+    for (int d = 0; d < MOVE_COUNT; d++)
+    {
+        unsigned int score;
+        if (ExecuteMove(board, d, &score) != board) available[count++] = d;
+    }
+
+    return count ? available[NextRandomBelow(random, count)] : MOVE_COUNT;
+}
+
+// Pick the move with the best immediate score, more empty cells break the ties
+static Direction GreedyPolicy(Bitboard board, RandomGenerator *random)
+{
+    Direction best = MOVE_COUNT;
+    long bestRank = -1;
+
+    for (int d = 0; d < MOVE_COUNT; d++)
+    {
+        unsigned int score;
+        Bitboard moved = ExecuteMove(board, d, &score);
+
+        if (moved == board) continue;
+
+        long rank = (long)score * BITBOARD_CELLS + CountEmptyCells(moved);
+        if (rank > bestRank)
+        {
+            bestRank = rank;
+            best = d;
+        }
+    }
+    return best;
+}
+
+// Keep the biggest tiles in the bottom left corner, move up only when stuck
+static Direction CornerPolicy(Bitboard board, RandomGenerator *random)
+{
+    static const Direction order[MOVE_COUNT] = { MOVE_DOWN, MOVE_LEFT, MOVE_RIGHT, MOVE_UP };
+
+    for (int i = 0; i < MOVE_COUNT; i++)
+    {
+        unsigned int score;
+        if (ExecuteMove(board, order[i], &score) != board) return order[i];
+    }
+    return MOVE_COUNT;
+}
+
+static Direction ExpectimaxPolicy(Bitboard board, RandomGenerator *random)
+{
+    SolverResult result = FindBestMove(&solver, board);
+
+    searchNodes += result.nodes;
+    searchTime  += result.elapsed;
+    searchCount++;
+
+    return result.move;
+}
+
+static GameResult PlayGame(Policy policy, RandomGenerator *random)
+{
+    GameResult result = { 0 };
+    Bitboard board = 0;
+
+    SpawnTile(&board, random);
+    SpawnTile(&board, random);
+
+    for (;;)
+    {
+        unsigned int score;
+        Direction direction = policy(board, random);
+
+        if (direction == MOVE_COUNT) break;
+
+        board = ExecuteMove(board, direction, &score);
+        result.score += score;
+        result.moves++;
+
+        SpawnTile(&board, random);
+    }
+
+    result.max = GetMaxExponent(board);
+    return result;
+}
+
+static void PrintReport(GameResult *results, int games, double elapsed)
+{
+    unsigned long long moves = 0;
+    unsigned long long total = 0;
+    int tiles[BITBOARD_MAX_VALUE + 1] = { 0 };
+
+    for (int i = 0; i < games; i++)
+    {
+        moves += results[i].moves;
+        total += results[i].score;
+        tiles[results[i].max]++;
+    }
+
+    qsort(results, games, sizeof(GameResult), CompareScores);
+
+    if (elapsed <= 0) elapsed = 1e-9;
+
+    printf("elapsed: %.3f s\n", elapsed);
+    printf("games/sec: %.1f\n", games / elapsed);
+    printf("moves/sec: %.0f\n", moves / elapsed);
+    printf("moves/game: %.1f\n", (double)moves / games);
+    printf("score: min %u, p25 %u, median %u, p75 %u, max %u, mean %.1f\n",
+           results[0].score, results[games / 4].score, results[games / 2].score,
+           results[games * 3 / 4].score, results[games - 1].score, (double)total / games);
+
+    printf("max tile:\n");
+    for (int value = 1; value <= BITBOARD_MAX_VALUE; value++)
+    {
+        if (tiles[value])
+        {
+            printf("  %6d: %6d (%5.1f%%)\n", 1 << value, tiles[value], 100.0 * tiles[value] / games);
+        }
+    }
+
+    if (searchCount)
+    {
+        printf("search: %.3f ms/move, %.0f nodes/sec\n",
+               1000 * searchTime / searchCount, searchTime > 0 ? searchNodes / searchTime : 0.0);
+    }
+}
+
+/*
+ * Collect positions from a corner policy game and search each of them to
+ * the fixed depth with a cold table. The one thread run is the reference,
+ * then the thread count doubles up to the requested one.
+ */
+static int RunScaling(SolverConfig config, RandomGenerator *random)
+{
+    Bitboard positions[SCALING_POSITIONS];
+    Bitboard board = 0;
+    int count = 0;
+    int moves = 0;
+
+    InitMoveTables();
+
+    SpawnTile(&board, random);
+    SpawnTile(&board, random);
+
+    while (count < SCALING_POSITIONS)
+    {
+        unsigned int score;
+        Direction direction = CornerPolicy(board, random);
+
+        if (direction == MOVE_COUNT)
+        {
+            board = 0;
+            SpawnTile(&board, random);
+            SpawnTile(&board, random);
+            continue;
+        }
+
+        board = ExecuteMove(board, direction, &score);
+        SpawnTile(&board, random);
+
+        if (++moves % 10 == 0) positions[count++] = board;
+    }
+
+    int maxThreads = config.threads > 0 ? config.threads : GetProcessorCount();
+    double reference = 0.0;
+
+    if (config.maxDepth == SOLVER_DEFAULT_DEPTH) config.maxDepth = SCALING_DEPTH;
+    config.timeBudget = 0;
+
+    printf("scaling: %d positions, depth %d\n", SCALING_POSITIONS, config.maxDepth);
+
+    for (int threads = 1; ; threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads)
+    {
+        unsigned long long nodes = 0;
+
+        config.threads = threads;
+        if (!InitSolver(&solver, config))
+        {
+            fprintf(stderr, "Solver initialization failed\n");
+            return 1;
+        }
+
+        double start = GetMonotonicTime();
+
+        for (int i = 0; i < SCALING_POSITIONS; i++)
+        {
+            ClearSolverTable(&solver);
+            nodes += FindBestMove(&solver, positions[i]).nodes;
+        }
+
+        double elapsed = GetMonotonicTime() - start;
+
+        UnloadSolver(&solver);
+
+        if (threads == 1) reference = elapsed;
+
+        printf("  threads %2d: %.3f s, %.0f nodes/sec, speedup %.2fx\n",
+               threads, elapsed, nodes / elapsed, reference / elapsed);
+
+        if (threads >= maxThreads) break;
+    }
+
+    return 0;
+}
+
+/*
+ * Move a set of random boards in random directions with every supported
+ * kernel, the results must match the scalar ExecuteMove() bit for bit.
+ */
+static int RunBatch(RandomGenerator *random)
+{
+    static Bitboard boards[BATCH_BOARDS], results[BATCH_BOARDS], expected[BATCH_BOARDS];
+    static Direction directions[BATCH_BOARDS];
+    static unsigned int scores[BATCH_BOARDS], expectedScores[BATCH_BOARDS];
+    static bool changed[BATCH_BOARDS];
+    int failed = 0;
+
+    InitMoveTables();
+
+    for (int i = 0; i < BATCH_BOARDS; i++)
+    {
+        for (int cell = 0; cell < BITBOARD_CELLS; cell++)
+        {
+            // Mostly small tiles so there are plenty of merges
+            unsigned int value = NextRandomBelow(random, 3) ? NextRandomBelow(random, 6)
+                                 : NextRandomBelow(random, BITBOARD_MAX_VALUE + 1);
+            boards[i] = SetCell(boards[i], cell, value);
+        }
+
+        directions[i] = NextRandomBelow(random, MOVE_COUNT);
+        expected[i]   = ExecuteMove(boards[i], directions[i], &expectedScores[i]);
+    }
+
+    printf("batch: %d boards x %d rounds\n", BATCH_BOARDS, BATCH_ROUNDS);
+
+    for (int kernel = 0; kernel < BATCH_KERNEL_COUNT; kernel++)
+    {
+        if (!SetBatchKernel(kernel))
+        {
+            printf("  %-6s: not supported\n", GetBatchKernelName(kernel));
+            continue;
+        }
+
+        int mismatches = 0;
+        double start = GetMonotonicTime();
+
+        for (int round = 0; round < BATCH_ROUNDS; round++)
+        {
+            MoveBatch(boards, directions, BATCH_BOARDS, results, scores, changed);
+        }
+
+        double elapsed = GetMonotonicTime() - start;
+
+        for (int i = 0; i < BATCH_BOARDS; i++)
+        {
+            if (results[i] != expected[i] || scores[i] != expectedScores[i] ||
+                changed[i] != (expected[i] != boards[i])) mismatches++;
+        }
+
+        printf("  %-6s: %.0f boards/sec, %s\n", GetBatchKernelName(kernel),
+               (double)BATCH_BOARDS * BATCH_ROUNDS / elapsed,
+               mismatches ? "MISMATCH" : "identical to scalar");
+
+        if (mismatches) failed = 1;
+    }
+
+    return failed;
+}
+
+/*
+ * Play every grid size with the same moves and spawns on the calling thread
+ * and on the pool, the runs must end with the same score.
+ */
+static int RunHuge(int threads, RandomGenerator *random)
+{
+    ThreadPool pool;
+    int failed = 0;
+
+    if (threads <= 0) threads = GetProcessorCount();
+
+    if (!InitThreadPool(&pool, threads))
+    {
+        fprintf(stderr, "Thread pool initialization failed\n");
+        return 1;
+    }
+
+    printf("huge: %d cell moves per size, %d threads\n", HUGE_CELL_MOVES, threads);
+
+    for (int size = 8; size <= HUGE_GRID_MAX_SIZE; size *= 2)
+    {
+        long moves = HUGE_CELL_MOVES / ((long)size * size);
+        uint64_t serialScore, parallelScore;
+        double serialTime, parallelTime;
+
+        if (!PlayHugeGrid(size, NULL, *random, moves, &serialScore, &serialTime) ||
+            !PlayHugeGrid(size, &pool, *random, moves, &parallelScore, &parallelTime))
+        {
+            fprintf(stderr, "Grid allocation failed\n");
+            failed = 1;
+            break;
+        }
+
+        printf("  %4dx%-4d: %10.0f moves/sec, %2d threads %10.0f moves/sec "
+               "(%6.0f Mcells/sec), speedup %.2fx%s\n", size, size, moves / serialTime,
+               threads, moves / parallelTime, (double)moves * size * size / parallelTime / 1e6,
+               serialTime / parallelTime, (serialScore != parallelScore) ? ", MISMATCH" : "");
+
+        if (serialScore != parallelScore) failed = 1;
+    }
+
+    UnloadThreadPool(&pool);
+
+    return failed;
+}
+
+// Half full grid of small tiles, the moves go around the directions with a spawn after each
+static bool PlayHugeGrid(int size, ThreadPool *pool, RandomGenerator random, long moves,
+                         uint64_t *score, double *elapsed)
+{
+    static const Direction order[MOVE_COUNT] = { MOVE_LEFT, MOVE_DOWN, MOVE_RIGHT, MOVE_UP };
+    HugeGrid grid;
+
+    *score = 0;
+    *elapsed = 0.0;
+
+    for (long i = 0; i < moves; )
+    {
+        if (!InitHugeGrid(&grid, size, pool)) return false;
+
+        for (long count = 0; count < (long)size * size / 2; count++)
+        {
+            long cell = SpawnHugeGridTile(&grid, &random);
+
+            SetHugeGridTile(&grid, cell, 1 + NextRandomBelow(&random, 8));
+        }
+
+        double start = GetMonotonicTime();
+
+        // Start over on a new grid when the game is lost
+        for (; i < moves && CanMoveHugeGrid(&grid); i++)
+        {
+            uint64_t gained;
+
+            MoveHugeGrid(&grid, order[i % MOVE_COUNT], &gained);
+            SpawnHugeGridTile(&grid, &random);
+
+            *score += gained;
+        }
+
+        *elapsed += GetMonotonicTime() - start;
+
+        UnloadHugeGrid(&grid);
+    }
+
+    if (*elapsed <= 0) *elapsed = 1e-9;
+
+    return true;
+}
+
+static int CompareScores(const void *a, const void *b)
+{
+    unsigned int sa = ((const GameResult *)a)->score;
+    unsigned int sb = ((const GameResult *)b)->score;
+
+    return (sa > sb) - (sa < sb);
+}
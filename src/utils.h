@@ -2,6 +2,7 @@
 #define UTILS_H
 
 #define MAX(a,b) (((a)>(b))?(a):(b))
+#define MIN(a,b) (((a)<(b))?(a):(b))
 
 int MakeSaveDir(char *dirpath);
 